@@ -0,0 +1,56 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// a minimal helper binary, built with and without PX_NO_IOSTREAM to compare
+// binary size and startup time
+
+#include "px.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv)
+{
+    auto n = 0;
+    auto ratio = 0.;
+    std::string name;
+
+    px::command_line cli("bench_minimal");
+    auto& help_arg = cli.add_flag_argument("help", "-h")
+	.set_alternate_tag("--help");
+    cli.add_value_argument<int>("count", "-n").bind(&n);
+    cli.add_value_argument<double>("ratio", "-r").bind(&ratio);
+    cli.add_value_argument<std::string>("name", "-s").bind(&name);
+
+    try
+    {
+	cli.parse(argc, argv);
+    }
+    catch (std::runtime_error& e)
+    {
+	std::fputs(e.what(), stderr);
+	return 1;
+    }
+
+    if (help_arg.get_value())
+    {
+	px::file_sink sink(stdout);
+	cli.print_help(sink);
+    }
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// when linked against px_static the declarations suffice; the header only
+// build of the same source is what the static build is compared against
+#ifdef PX_STATIC
+#include "px_decl.h"
+#else
+#include "px.h"
+#endif
+
+#include "perf_counters.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+void build_and_parse_distinct_types(const std::vector<std::string>& args);
+
+namespace
+{
+    template <typename function>
+    void run(std::string_view name, int iterations, function&& f)
+    {
+        bench::perf_counter instructions(bench::perf_counter::event::instructions);
+        bench::perf_counter icache_misses(bench::perf_counter::event::icache_misses);
+        instructions.start();
+        icache_misses.start();
+        const auto start = std::chrono::steady_clock::now();
+        for (auto i = 0; i < iterations; ++i)
+        {
+            f();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto misses = icache_misses.stop();
+        const auto instruction_count = instructions.stop();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        std::cout << name << ": " << ns / iterations << " ns/iteration";
+        if (instruction_count)
+        {
+            std::cout << ", " << *instruction_count / iterations << " instructions/iteration";
+        }
+        if (misses)
+        {
+            std::cout << ", " << *misses / iterations << " i-cache misses/iteration";
+        }
+        std::cout << "\n";
+    }
+
+    void build_and_parse(const std::vector<std::string>& args)
+    {
+        auto i = 0;
+        auto l = 0L;
+        auto d = 0.;
+        std::string s;
+        std::filesystem::path p;
+        std::vector<int> v;
+
+        px::command_line cli("bench_px");
+        cli.add_flag_argument("help", "-h").set_alternate_tag("--help");
+        cli.add_value_argument<int>("integer", "-i").bind(&i);
+        cli.add_value_argument<long>("long", "-l").bind(&l);
+        cli.add_value_argument<double>("double", "-d").bind(&d);
+        cli.add_value_argument<std::string>("string", "-s").bind(&s);
+        cli.add_value_argument<std::filesystem::path>("path", "-p").bind(&p);
+        cli.add_multi_value_argument<int>("integers", "--ints").bind(&v);
+        cli.parse(args);
+    }
+
+    // tags of one length, or of lengths from 3 to 26 characters
+    std::string make_tag(int i, bool same_length)
+    {
+        std::string letters;
+        for (auto n = i; letters.size() < static_cast<std::size_t>(same_length ? 4 : 3 + i % 24); n /= 26)
+        {
+            letters += static_cast<char>('a' + n % 26);
+        }
+        return "--" + letters;
+    }
+
+    // the crossovers of comparing each tag, comparing inline keys and
+    // hashing, parsing 32 tags and their values spread over the schema
+    void bench_dispatch(int iterations)
+    {
+        const char* strategy_names[] = { "automatic", "linear", "hashed", "inline keys" };
+        for (const auto same_length : { true, false })
+        {
+            for (const auto n : { 2, 4, 8, 16, 32, 64, 128, 1024, 4096 })
+            {
+                std::vector<std::string> names;
+                std::vector<std::string> tags;
+                std::vector<std::string> args{ "bench_px" };
+                for (auto i = 0; i < n; ++i)
+                {
+                    names.push_back("option " + std::to_string(i));
+                    tags.push_back(make_tag(i, same_length));
+                }
+                for (auto i = 0; i < 32; ++i)
+                {
+                    args.push_back(tags[(i * 7919) % n]);
+                    args.push_back(std::to_string(i));
+                }
+
+                for (const auto strategy : { px::dispatch_strategy::linear, px::dispatch_strategy::hashed,
+                    px::dispatch_strategy::inline_keys })
+                {
+                    px::command_line cli("bench_px");
+                    for (auto i = 0; i < n; ++i)
+                    {
+                        cli.add_value_argument<int>(names[i], tags[i]);
+                    }
+                    cli.set_dispatch(strategy);
+                    const auto name = std::string("dispatch ") + strategy_names[static_cast<int>(strategy)] +
+                        ", " + std::to_string(n) + (same_length ? " tags of one length" : " tags of mixed lengths");
+                    run(name, std::max(1000, iterations * 8 / n), [&cli, &args]() { cli.parse(args); });
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const auto iterations = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    const std::vector<std::string> args{ "bench_px", "-i", "1", "-l", "2", "-d", "3.5",
+        "-s", "four", "-p", "/tmp/five", "--ints", "6", "7", "8", "-h" };
+
+#ifdef PX_STATIC
+    std::cout << "px_static\n";
+#else
+    std::cout << "header only\n";
+#endif
+    run("build and parse", iterations, [&args]() { build_and_parse(args); });
+
+    std::vector<std::string> distinct_args{ "bench_px" };
+    for (auto i = 0; i < 40; i += 4)
+    {
+        distinct_args.push_back("-i" + std::to_string(i));
+        distinct_args.push_back(std::to_string(i));
+    }
+    run("build and parse, 40 value types", iterations / 10, [&distinct_args]()
+        {
+            build_and_parse_distinct_types(distinct_args);
+        });
+
+    // lookup by name among 1000 arguments, hashing the name per call and
+    // with the key hashed at compile time
+    std::vector<std::string> names;
+    std::vector<std::string> tags;
+    for (auto i = 0; i < 1000; ++i)
+    {
+        names.push_back("option " + std::to_string(i));
+        tags.push_back("--opt" + std::to_string(i));
+    }
+    px::command_line many("bench_px");
+    for (auto i = 0; i < 1000; ++i)
+    {
+        many.add_value_argument<int>(names[i], tags[i]);
+    }
+    many.parse(std::vector<std::string>{ "bench_px", "--opt500", "500" });
+
+    volatile int sink = 0;
+    run("get by name", iterations * 10, [&many, &sink]() { sink = many.get<int>("option 500"); });
+    constexpr px::name_key key("option 500");
+    run("get by hashed key", iterations * 10, [&many, &sink, key]() { sink = many.get<int>(key); });
+
+    bench_dispatch(iterations);
+
+    return 0;
+}
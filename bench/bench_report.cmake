@@ -0,0 +1,44 @@
+# usage: cmake -DCXX=... -DINCLUDE_DIR=... -DSOURCE=... -DTYPES_SOURCE=... -DWORK_DIR=... -DHEADER_ONLY_BINARY=... -DSTATIC_BINARY=... -DMINIMAL_BINARY=... -DNO_IOSTREAM_BINARY=... -P bench_report.cmake
+cmake_minimum_required(VERSION 3.23) # for the %f timestamp format
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(compile_time label source defines)
+  string(TIMESTAMP start "%s%f")
+  execute_process(
+    COMMAND ${CXX} -std=c++20 -O2 -I${INCLUDE_DIR} ${defines} -c ${source} -o ${WORK_DIR}/${label}.o
+    RESULT_VARIABLE result)
+  string(TIMESTAMP stop "%s%f")
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "compiling ${source} (${label}) failed")
+  endif()
+  math(EXPR ms "(${stop} - ${start}) / 1000")
+  file(SIZE ${WORK_DIR}/${label}.o size)
+  message("${label}: compile ${ms} ms, object ${size} bytes")
+endfunction()
+
+compile_time(header_only ${SOURCE} "")
+compile_time(px_static ${SOURCE} "-DPX_STATIC")
+# the code size of 40 distinct value types is what the type independent
+# argument cores keep small
+compile_time(40_value_types ${TYPES_SOURCE} "-DPX_STATIC")
+
+foreach(binary ${HEADER_ONLY_BINARY} ${STATIC_BINARY} ${MINIMAL_BINARY} ${NO_IOSTREAM_BINARY})
+  file(SIZE ${binary} size)
+  get_filename_component(name ${binary} NAME)
+  message("${name}: ${size} bytes")
+endforeach()
+
+# the process spawn overhead is the same for both, so the difference between
+# the two is what iostreams add to startup
+set(runs 200)
+foreach(binary ${MINIMAL_BINARY} ${NO_IOSTREAM_BINARY})
+  string(TIMESTAMP start "%s%f")
+  foreach(run RANGE 1 ${runs})
+    execute_process(COMMAND ${binary} -n 3 -r 0.5 -s name)
+  endforeach()
+  string(TIMESTAMP stop "%s%f")
+  math(EXPR us "(${stop} - ${start}) / ${runs}")
+  get_filename_component(name ${binary} NAME)
+  message("${name}: ${us} us per run")
+endforeach()
@@ -0,0 +1,84 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// writes a large response file and reports the throughput of mapping and
+// tokenizing it on a growing number of threads
+
+#include "px_response.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    auto megabytes = 256;
+    std::vector<int> threads{ 1, 2, 4, 8 };
+
+    px::command_line cli("bench_response");
+    cli.add_value_argument<int>("megabytes", "-m")
+	.set_alternate_tag("--megabytes")
+	.set_description("the size of the response file")
+	.set_validator([](auto m) { return m > 0; })
+	.bind(&megabytes);
+    cli.add_multi_value_argument<int>("threads", "-t")
+	.set_alternate_tag("--threads")
+	.set_description("the thread counts to tokenize with")
+	.bind(&threads);
+
+    try
+    {
+	cli.parse(argc, argv);
+    }
+    catch (std::runtime_error& e)
+    {
+	std::cerr << e.what() << "\n\n";
+	cli.print_help(std::cerr);
+	return 1;
+    }
+
+    const auto path = std::filesystem::temp_directory_path() / "bench_response.rsp";
+    {
+        std::ofstream file(path, std::ios::binary);
+        const auto size = static_cast<std::size_t>(megabytes) << 20;
+        std::string line;
+        for (std::size_t written = 0, i = 0; written < size; written += line.size(), ++i)
+        {
+            line = "--opt" + std::to_string(i % 1000) + " " + std::to_string(i) +
+                " --name 'a quoted value " + std::to_string(i) + "'\n";
+            file << line;
+        }
+    }
+
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "tokens" << std::setw(10) << "ms"
+              << std::setw(10) << "MB/s" << "\n";
+    for (const auto t : threads)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const px::response_file file(path, static_cast<std::size_t>(t));
+        const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::setw(8) << t << std::setw(12) << file.get_tokens().size() << std::fixed << std::setprecision(0)
+                  << std::setw(10) << ms << std::setw(10) << megabytes / ms * 1000. << "\n";
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// sends commands over a unix socket to a command_server and reports the
+// commands handled per second and percentiles of the latency from sending a
+// command to the end of its handler
+
+#include "px_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    double percentile(std::vector<double> v, double p)
+    {
+        std::sort(v.begin(), v.end());
+        const auto i = static_cast<std::size_t>(p / 100. * static_cast<double>(v.size() - 1) + .5);
+        return v[i];
+    }
+
+    void run(int commands, int workers, px::framing frame)
+    {
+        px::schema_builder builder("bench_server");
+        const px::schema_key<int> sequence = builder.add_value_argument<int>("sequence", "-s").set_required(true);
+        const px::schema_key<std::string> name = builder.add_value_argument<std::string>("name", "--name");
+        const px::schema_key<double> ratio = builder.add_value_argument<double>("ratio", "--ratio");
+        const px::schema_key<bool> verbose = builder.add_flag_argument("verbose", "-v");
+        for (auto i = 0; i < 100; ++i)
+        {
+            builder.add_value_argument<int>("option", "--opt" + std::to_string(i));
+        }
+        const auto schema = std::move(builder).freeze();
+
+        std::vector<clock_type::time_point> sent(static_cast<std::size_t>(commands));
+        std::vector<clock_type::time_point> handled(static_cast<std::size_t>(commands));
+
+        px::command_server server(schema, static_cast<std::size_t>(workers));
+        const auto record = [&](const px::parse_result& r)
+        {
+            // touch the values, as a real handler would
+            const volatile auto used = r.get(name).size() + static_cast<std::size_t>(r.get(ratio)) + r.get(verbose);
+            static_cast<void>(used);
+            handled[static_cast<std::size_t>(r.get(sequence))] = clock_type::now();
+        };
+        server.on("set", record);
+        server.on("get", record);
+
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            throw std::runtime_error("could not create socket pair");
+        }
+
+        std::thread client([&]()
+            {
+                px::command_client c(fds[1], frame);
+                for (auto i = 0; i < commands; ++i)
+                {
+                    const auto command = std::string((i % 2 == 0) ? "set" : "get") +
+                        " -s " + std::to_string(i) + " --name 'client name' --ratio 0.5 -v --opt" +
+                        std::to_string(i % 100) + " " + std::to_string(i);
+                    sent[static_cast<std::size_t>(i)] = clock_type::now();
+                    c.send(command);
+                }
+                ::shutdown(fds[1], SHUT_WR);
+            });
+        const auto start = clock_type::now();
+        server.serve(fds[0], frame);
+        const auto stop = clock_type::now();
+        client.join();
+        ::close(fds[0]);
+        ::close(fds[1]);
+
+        std::vector<double> latency;
+        for (std::size_t i = 0; i < sent.size(); ++i)
+        {
+            latency.push_back(std::chrono::duration<double, std::micro>(handled[i] - sent[i]).count());
+        }
+        const auto seconds = std::chrono::duration<double>(stop - start).count();
+
+        std::cout << std::left << std::setw(16) << (frame == px::framing::newline ? "newline" : "length")
+                  << std::right << std::setw(8) << workers << std::fixed << std::setprecision(0)
+                  << std::setw(14) << commands / seconds
+                  << std::setprecision(1)
+                  << std::setw(10) << percentile(latency, 50)
+                  << std::setw(10) << percentile(latency, 99)
+                  << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    auto commands = 200000;
+    std::vector<int> workers{ 1, 2, 4, 8 };
+
+    px::command_line cli("bench_server");
+    cli.add_value_argument<int>("commands", "-c")
+	.set_alternate_tag("--commands")
+	.set_description("the number of commands sent per run")
+	.set_validator([](auto c) { return c > 0; })
+	.bind(&commands);
+    cli.add_multi_value_argument<int>("workers", "-w")
+	.set_alternate_tag("--workers")
+	.set_description("the worker pool sizes to run with")
+	.bind(&workers);
+
+    try
+    {
+	cli.parse(argc, argv);
+    }
+    catch (std::runtime_error& e)
+    {
+	std::cerr << e.what() << "\n\n";
+	cli.print_help(std::cerr);
+	return 1;
+    }
+
+    std::cout << std::left << std::setw(16) << "framing" << std::right << std::setw(8) << "workers"
+              << std::setw(14) << "commands/s" << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << "\n";
+    for (const auto frame : { px::framing::newline, px::framing::length_prefixed })
+    {
+        for (const auto w : workers)
+        {
+            run(commands, w, frame);
+        }
+    }
+
+    return 0;
+}
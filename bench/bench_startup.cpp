@@ -0,0 +1,173 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// runs the programs written by gen_startup_program many times each and
+// reports percentiles of the time from exec to parsed arguments, of the page
+// faults and of the peak resident set size
+
+#include "px.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace
+{
+    struct sample
+    {
+        double wall_us;
+        long minor_faults;
+        long major_faults;
+        long max_rss_kb;
+    };
+
+    // the options every program is given; all programs register at least these
+    constexpr auto given_options = 10;
+
+    sample run_once(const std::filesystem::path& program)
+    {
+        std::vector<std::string> args{ program.string() };
+        for (auto i = 0; i < given_options; ++i)
+        {
+            args.push_back("--opt" + std::to_string(i));
+            args.push_back(std::to_string(i + 1));
+        }
+        std::vector<char*> argv;
+        for (auto& a : args)
+        {
+            argv.push_back(a.data());
+        }
+        argv.push_back(nullptr);
+
+        const auto start = std::chrono::steady_clock::now();
+        pid_t pid;
+        if (posix_spawn(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+        {
+            throw std::runtime_error("could not spawn '" + program.string() + "'");
+        }
+        int status = 0;
+        rusage usage{};
+        wait4(pid, &status, 0, &usage);
+        const auto stop = std::chrono::steady_clock::now();
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            throw std::runtime_error("'" + program.string() + "' failed");
+        }
+
+        return { std::chrono::duration<double, std::micro>(stop - start).count(),
+            usage.ru_minflt, usage.ru_majflt, usage.ru_maxrss };
+    }
+
+    template <typename T>
+    T percentile(std::vector<T> v, double p)
+    {
+        std::sort(v.begin(), v.end());
+        const auto i = static_cast<std::size_t>(p / 100. * static_cast<double>(v.size() - 1) + .5);
+        return v[i];
+    }
+
+    void report(const std::filesystem::path& program, const std::vector<sample>& samples)
+    {
+        const auto field = [&samples](auto member)
+        {
+            std::vector<std::remove_cvref_t<decltype(samples[0].*member)>> v;
+            for (const auto& s : samples)
+            {
+                v.push_back(s.*member);
+            }
+            return v;
+        };
+        const auto wall = field(&sample::wall_us);
+        const auto faults = field(&sample::minor_faults);
+        const auto major = field(&sample::major_faults);
+        const auto rss = field(&sample::max_rss_kb);
+
+        std::cout << std::left << std::setw(32) << program.filename().string() << std::right << std::fixed
+                  << std::setprecision(0)
+                  << std::setw(10) << percentile(wall, 50)
+                  << std::setw(10) << percentile(wall, 90)
+                  << std::setw(10) << percentile(wall, 99)
+                  << std::setw(10) << percentile(faults, 50)
+                  << std::setw(10) << percentile(faults, 99)
+                  << std::setw(8) << percentile(major, 99)
+                  << std::setw(12) << percentile(rss, 50)
+                  << std::setw(12) << percentile(rss, 100)
+                  << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    auto runs = 200;
+    std::vector<std::filesystem::path> programs;
+
+    px::command_line cli("bench_startup");
+    cli.add_value_argument<int>("runs", "-r")
+	.set_alternate_tag("--runs")
+	.set_description("the number of times each program is run")
+	.set_validator([](auto r) { return r > 0; })
+	.bind(&runs);
+    cli.add_multi_value_argument<std::filesystem::path>("programs", "-p")
+	.set_alternate_tag("--programs")
+	.set_required(true)
+	.set_description("the programs written by gen_startup_program")
+	.bind(&programs);
+
+    try
+    {
+	cli.parse(argc, argv);
+    }
+    catch (std::runtime_error& e)
+    {
+	std::cerr << e.what() << "\n\n";
+	cli.print_help(std::cerr);
+	return 1;
+    }
+
+    std::cout << std::left << std::setw(32) << "program" << std::right
+              << std::setw(10) << "p50 us" << std::setw(10) << "p90 us" << std::setw(10) << "p99 us"
+              << std::setw(10) << "p50 flt" << std::setw(10) << "p99 flt" << std::setw(8) << "majflt"
+              << std::setw(12) << "p50 rss kB" << std::setw(12) << "max rss kB" << "\n";
+    for (const auto& program : programs)
+    {
+        // the first runs only warm up the page cache
+        for (auto i = 0; i < 5; ++i)
+        {
+            run_once(program);
+        }
+        std::vector<sample> samples;
+        for (auto i = 0; i < runs; ++i)
+        {
+            samples.push_back(run_once(program));
+        }
+        report(program, samples);
+    }
+
+    return 0;
+}
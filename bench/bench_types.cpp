@@ -0,0 +1,51 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// argument types beyond the common ones always need the full header
+
+#include "px.h"
+
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // distinct value types, to measure what every additional argument type
+    // costs in code size and instruction cache footprint
+    template <int N>
+    struct distinct_int
+    {
+        int value = 0;
+        friend std::istream& operator>>(std::istream& i, distinct_int& d) { return i >> d.value; }
+    };
+
+    template <int... N>
+    void build_and_parse(const std::vector<std::string>& args, std::integer_sequence<int, N...>)
+    {
+        px::command_line cli("bench_px");
+        (cli.add_value_argument<distinct_int<N>>("integer " + std::to_string(N), "-i" + std::to_string(N)), ...);
+        cli.parse(args);
+    }
+}
+
+void build_and_parse_distinct_types(const std::vector<std::string>& args)
+{
+    build_and_parse(args, std::make_integer_sequence<int, 40>{});
+}
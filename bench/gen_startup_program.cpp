@@ -0,0 +1,164 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// writes the source of a program that registers a given number of value
+// arguments --opt0 ... --optN-1, parses its command line and exits; either
+// with px::command_line (dynamic), with px::static_command_line (static) or
+// with a px::frozen_schema (frozen)
+
+#include "px.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    // registrations are split over functions, as they would be over the
+    // modules of a real tool, and to keep the generated functions compilable
+    constexpr auto arguments_per_function = 100;
+
+    void write_dynamic(std::ostream& o, int n)
+    {
+        o << "#include \"px.h\"\n"
+          << "#include <cstdlib>\n\n"
+          << "static int values[" << n << "];\n\n";
+        const auto functions = (n + arguments_per_function - 1) / arguments_per_function;
+        for (auto f = 0; f < functions; ++f)
+        {
+            o << "static void register_" << f << "(px::command_line& cli)\n{\n";
+            for (auto i = f * arguments_per_function; i < std::min(n, (f + 1) * arguments_per_function); ++i)
+            {
+                o << "    cli.add_value_argument<int>(\"option " << i << "\", \"--opt" << i << "\")"
+                  << ".set_description(\"the value of option " << i << "\")"
+                  << ".bind(&values[" << i << "]);\n";
+            }
+            o << "}\n\n";
+        }
+        o << "int main(int argc, char** argv)\n{\n"
+          << "    px::command_line cli(\"startup\");\n";
+        for (auto f = 0; f < functions; ++f)
+        {
+            o << "    register_" << f << "(cli);\n";
+        }
+        o << "    cli.parse(argc, argv);\n"
+          << "    // exit as soon as the arguments are parsed\n"
+          << "    std::_Exit(values[0] == 0);\n"
+          << "}\n";
+    }
+
+    void write_frozen(std::ostream& o, int n)
+    {
+        o << "#include \"px_frozen.h\"\n"
+          << "#include <cstdlib>\n\n"
+          << "static px::schema_key<int> keys[" << n << "];\n\n";
+        const auto functions = (n + arguments_per_function - 1) / arguments_per_function;
+        for (auto f = 0; f < functions; ++f)
+        {
+            o << "static void register_" << f << "(px::schema_builder& schema)\n{\n";
+            for (auto i = f * arguments_per_function; i < std::min(n, (f + 1) * arguments_per_function); ++i)
+            {
+                o << "    keys[" << i << "] = schema.add_value_argument<int>(\"option " << i << "\", \"--opt" << i << "\")"
+                  << ".set_description(\"the value of option " << i << "\");\n";
+            }
+            o << "}\n\n";
+        }
+        o << "int main(int argc, char** argv)\n{\n"
+          << "    px::schema_builder builder(\"startup\");\n";
+        for (auto f = 0; f < functions; ++f)
+        {
+            o << "    register_" << f << "(builder);\n";
+        }
+        o << "    const auto schema = std::move(builder).freeze();\n"
+          << "    const auto values = schema.parse(argc, argv);\n"
+          << "    // exit as soon as the arguments are parsed\n"
+          << "    std::_Exit(!values.has_value(keys[0]));\n"
+          << "}\n";
+    }
+
+    void write_static(std::ostream& o, int n)
+    {
+        o << "#include \"px_preset.h\"\n"
+          << "#include <cstdlib>\n\n"
+          << "struct options\n{\n";
+        for (auto i = 0; i < n; ++i)
+        {
+            o << "    int opt" << i << " = 0;\n";
+        }
+        o << "};\n\n"
+          << "static constexpr px::static_command_line cli(\n";
+        for (auto i = 0; i < n; ++i)
+        {
+            o << "    px::static_argument(\"--opt" << i << "\", &options::opt" << i << ")"
+              << ((i + 1 < n) ? ",\n" : ");\n\n");
+        }
+        o << "int main(int argc, char** argv)\n{\n"
+          << "    const auto values = cli.parse(argc, argv);\n"
+          << "    // exit as soon as the arguments are parsed\n"
+          << "    std::_Exit(values.opt0 == 0);\n"
+          << "}\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    auto n = 0;
+    std::string mode;
+    std::string output;
+
+    px::command_line cli("gen_startup_program");
+    cli.add_value_argument<int>("arguments", "-n")
+	.set_required(true)
+	.set_description("the number of arguments the program registers")
+	.set_validator([](auto n) { return n > 0; })
+	.bind(&n);
+    cli.add_value_argument<std::string>("mode", "-m")
+	.set_required(true)
+	.set_description("the schema mode of the program: dynamic, static or frozen")
+	.set_validator([](const auto& m) { return m == "dynamic" || m == "static" || m == "frozen"; })
+	.bind(&mode);
+    cli.add_value_argument<std::string>("output", "-o")
+	.set_required(true)
+	.set_description("the source file to write")
+	.bind(&output);
+
+    try
+    {
+	cli.parse(argc, argv);
+    }
+    catch (std::runtime_error& e)
+    {
+	std::cerr << e.what() << "\n\n";
+	cli.print_help(std::cerr);
+	return 1;
+    }
+
+    std::ofstream o(output);
+    if (mode == "dynamic")
+    {
+        write_dynamic(o, n);
+    }
+    else if (mode == "frozen")
+    {
+        write_frozen(o, n);
+    }
+    else
+    {
+        write_static(o, n);
+    }
+    return o ? 0 : 1;
+}
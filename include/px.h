@@ -18,653 +18,2148 @@
 
 #pragma once
 
+#include "px_decl.h"
+#include "px_tokenize.h"
+
 #include <algorithm>
+#include <bit>
 #include <cctype>
-#if __has_include(<format>)
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#if __has_include(<format>) && !defined(PX_NO_IOSTREAM)
 #include <format>
 #define PX_HAS_FORMAT
 #endif
-#include <functional>
-#include <memory>
-#include <optional>
-#include <sstream>
-#if __has_include(<span>)
-#include <span>
-#define PX_HAS_SPAN
+#include <initializer_list>
+#include <iterator>
+#ifndef PX_NO_IOSTREAM
+#include <sstream>
+#endif
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PX_HAS_SSE2
+#endif
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define PX_HAS_MMAP
+#endif
+
+namespace detail
+{
+    // joins the pieces with a single allocation
+    inline std::string concat(std::initializer_list<std::string_view> pieces)
+    {
+        std::string s;
+        std::size_t size = 0;
+        for (const auto& piece : pieces)
+        {
+            size += piece.size();
+        }
+        s.reserve(size);
+        for (const auto& piece : pieces)
+        {
+            s.append(piece);
+        }
+        return s;
+    }
+
+#ifdef PX_TRACE
+    // the tracer of the parse running on this thread
+    inline thread_local px::parse_tracer* active_tracer = nullptr;
+
+    class tracing_scope
+    {
+    public:
+        explicit tracing_scope(px::parse_tracer* t) :
+            previous(std::exchange(active_tracer, t))
+        {
+        }
+        tracing_scope(const tracing_scope&) = delete;
+        tracing_scope& operator=(const tracing_scope&) = delete;
+        ~tracing_scope()
+        {
+            active_tracer = previous;
+        }
+
+    private:
+        px::parse_tracer* previous;
+    };
+
+    // records the time from its construction to its destruction
+    class trace_span
+    {
+    public:
+        trace_span(std::string_view n, const char* c) :
+            tracer(active_tracer),
+            name(n),
+            category(c),
+            begin((tracer != nullptr) ? now() : 0)
+        {
+        }
+        trace_span(const trace_span&) = delete;
+        trace_span& operator=(const trace_span&) = delete;
+        ~trace_span()
+        {
+            if (tracer != nullptr)
+            {
+                tracer->record(name, category, begin, now());
+            }
+        }
+
+    private:
+        static std::int64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        px::parse_tracer* tracer;
+        std::string_view name;
+        const char* category;
+        std::int64_t begin;
+    };
+#else
+    class trace_span
+    {
+    public:
+        constexpr trace_span(std::string_view, const char*) {}
+    };
+#endif
+
+    inline auto pad_right(std::string_view s, decltype(s.size()) n)
+    {
+	constexpr decltype(s.size()) zero {0};
+        return std::string(s).append(std::max(zero, n - s.size()), ' ');
+    }
+
+    template <typename T>
+    constexpr bool is_from_chars_convertible = std::is_arithmetic_v<T> &&
+        !std::is_same_v<T, bool> && !std::is_same_v<T, char> &&
+        !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>;
+
+    template <typename T>
+    constexpr bool is_string_constructible = std::is_constructible_v<T, const std::string&> &&
+        !std::is_convertible_v<T, std::string_view>;
+
+    template <typename>
+    constexpr bool dependent_false = false;
+
+    template <typename T>
+    inline constexpr char type_tag = 0;
+
+    // identifies a type without RTTI
+    template <typename T>
+    constexpr type_id type_id_of()
+    {
+        return &type_tag<T>;
+    }
+
+    template <typename T>
+    struct is_vector : std::false_type {};
+
+    template <typename T>
+    struct is_vector<std::vector<T>> : std::true_type {};
+
+    [[noreturn]] inline void throw_could_not_parse(std::string_view s)
+    {
+        throw std::runtime_error(concat({ "could not parse from '", s, "'" }));
+    }
+
+    template <typename T>
+    T parse_from_chars(std::string_view s)
+    {
+        // from_chars does not accept the leading plus that streams do
+        const auto skip_plus = s.size() > 1 && s[0] == '+' && s[1] != '-';
+        const auto first = s.data() + (skip_plus ? 1 : 0);
+        const auto last = s.data() + s.size();
+
+        T t{};
+        if constexpr (std::is_floating_point_v<T>)
+        {
+#ifdef __cpp_lib_to_chars
+            const auto [ptr, ec] = std::from_chars(first, last, t);
+            if (first == last || ec != std::errc() || ptr != last)
+            {
+                throw_could_not_parse(s);
+            }
+#else
+            // strtold needs a terminated string
+            const std::string terminated(first, last);
+            char* ptr = nullptr;
+            t = static_cast<T>(std::strtold(terminated.c_str(), &ptr));
+            if (terminated.empty() || ptr != terminated.c_str() + terminated.size())
+            {
+                throw_could_not_parse(s);
+            }
+#endif
+        }
+        else
+        {
+            const auto [ptr, ec] = std::from_chars(first, last, t);
+            if (first == last || ec != std::errc() || ptr != last)
+            {
+                throw_could_not_parse(s);
+            }
+        }
+        return t;
+    }
+
+    inline bool parse_bool(std::string_view s)
+    {
+        if (s == "1" || s == "true")
+        {
+            return true;
+        }
+        else if (s == "0" || s == "false")
+        {
+            return false;
+        }
+        throw_could_not_parse(s);
+    }
+
+    template <typename T>
+    auto parse_scalar(std::string_view s)
+    {
+        if constexpr (std::is_same_v<std::string, T>)
+        {
+            return std::string(s);
+        }
+        else if constexpr (std::is_same_v<std::string_view, T>)
+        {
+            return s;
+        }
+        else if constexpr (std::is_same_v<bool, T>)
+        {
+            return parse_bool(s);
+        }
+        else if constexpr (is_from_chars_convertible<T>)
+        {
+            return parse_from_chars<T>(s);
+        }
+        else if constexpr (is_string_constructible<T>)
+        {
+            return T(std::string(s));
+        }
+        else
+        {
+#ifndef PX_NO_IOSTREAM
+            std::istringstream stream{ std::string(s) };
+            T t;
+            stream >> t;
+            if (!stream.eof() || stream.fail())
+            {
+                throw_could_not_parse(s);
+            }
+            return t;
+#else
+            static_assert(dependent_false<T>,
+                "without iostreams, values must be arithmetic or constructible from std::string");
+#endif
+        }
+    }
+
+    // the text of a file, or nothing when it cannot be read
+    inline std::optional<std::string> read_file(const std::string& path)
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+
+        std::string text;
+        char buffer[4096];
+        for (auto n = std::fread(buffer, 1, sizeof(buffer), file.get()); n > 0;
+             n = std::fread(buffer, 1, sizeof(buffer), file.get()))
+        {
+            text.append(buffer, n);
+        }
+        return text;
+    }
+
+    // the most tags, and tags of one length, for which automatic dispatch
+    // compares a token with each tag rather than hashing it, and the most
+    // tags and least mean length for which it compares inline keys; tags
+    // longer than the keys rule these out. bench_px measures the crossovers
+    constexpr std::size_t linear_dispatch_tags = 16;
+    constexpr std::size_t linear_dispatch_same_length = 2;
+    constexpr std::size_t inline_dispatch_tags = 128;
+    constexpr std::size_t inline_dispatch_mean_length = 8;
+
+    inline auto is_separator_tag(std::string_view s)
+    {
+        return s.size() == 2 && s[0] == '-' && s[1] == '-';
+    }
+
+    inline auto is_short_tag(std::string_view s)
+    {
+        return (s.size() > 1 && s[0] == '-' && !std::isdigit(s[1]));
+    }
+
+    inline auto is_alternate_tag(std::string_view s)
+    {
+        return (s.size() > 2 && s[0] == '-' && s[1] == '-' && !std::isdigit(s[2]));
+    }
+
+    inline auto is_tag(std::string_view s)
+    {
+        return !s.empty() && !is_separator_tag(s) &&
+             (is_short_tag(s) || is_alternate_tag(s));
+    }
+
+    // one line of help for a tag argument
+    inline std::string format_validator_help(std::string_view help)
+    {
+        return help.empty() ? std::string() : concat({ " (", help, ")" });
+    }
+
+    // a value as it would be given, for the help
+    template <typename T>
+    std::string format_value(const T& t)
+    {
+        if constexpr (is_vector<T>::value)
+        {
+            std::string s;
+            for (const auto& e : t)
+            {
+                s += s.empty() ? "" : " ";
+                s += format_value(e);
+            }
+            return s;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return t ? "true" : "false";
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            char buffer[64];
+            const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), t);
+            return std::string(buffer, end);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+        {
+            return std::string(std::string_view(t));
+        }
+        else if constexpr (requires { t.string(); })
+        {
+            return t.string();
+        }
+#ifndef PX_NO_IOSTREAM
+        else if constexpr (requires(std::ostream& o) { o << t; })
+        {
+            std::ostringstream o;
+            o << t;
+            return o.str();
+        }
+#endif
+        else
+        {
+            return "...";
+        }
+    }
+
+    // the bytes a value allocates, where they can be known
+    template <typename T>
+    std::size_t heap_bytes(const T& t)
+    {
+        if constexpr (is_vector<T>::value)
+        {
+            auto bytes = t.capacity() * sizeof(typename T::value_type);
+            for (const auto& e : t)
+            {
+                bytes += heap_bytes(e);
+            }
+            return bytes;
+        }
+        else if constexpr (requires { t.native(); })
+        {
+            return heap_bytes(t.native());
+        }
+        else if constexpr (requires { typename T::traits_type; t.capacity(); })
+        {
+            // a string allocates once it outgrows its inline buffer
+            return t.capacity() > T().capacity() ? (t.capacity() + 1) * sizeof(typename T::value_type) : 0;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    inline std::string format_tag_help(std::string_view tag, std::string_view alternate_tag,
+        bool required, std::string_view description, std::string_view validator_help = {},
+        std::string_view default_value = {})
+    {
+        constexpr auto alternate_tag_size = 15;
+        return concat({ "   ", tag,
+            (!alternate_tag.empty()) ?
+                ", " + pad_right(alternate_tag, alternate_tag_size - 2) :
+                pad_right("", alternate_tag_size),
+            (required) ? "(required) " : "",
+            description,
+            format_validator_help(validator_help),
+            default_value.empty() ? "" : concat({ " (default ", default_value, ")" }),
+            "\n" });
+    }
+
+    inline void tag_keys::clear()
+    {
+        fingerprints.clear();
+        keys.clear();
+        slots.clear();
+        longer.clear();
+    }
+
+    inline std::uint8_t tag_keys::fingerprint(std::string_view s)
+    {
+        // the first and last 8 or 4 bytes, overlapping in shorter tags,
+        // so that it costs the same for any tag
+        std::uint64_t first = 0;
+        std::uint64_t last = 0;
+        if (s.size() >= 8)
+        {
+            std::memcpy(&first, s.data(), 8);
+            std::memcpy(&last, s.data() + s.size() - 8, 8);
+        }
+        else if (s.size() >= 4)
+        {
+            std::uint32_t a, b;
+            std::memcpy(&a, s.data(), 4);
+            std::memcpy(&b, s.data() + s.size() - 4, 4);
+            first = a;
+            last = b;
+        }
+        else if (!s.empty())
+        {
+            first = static_cast<unsigned char>(s[0]) | static_cast<unsigned char>(s[s.size() / 2]) << 8 |
+                static_cast<unsigned char>(s.back()) << 16;
+        }
+        constexpr auto k = 0x9e3779b97f4a7c15ull;
+        return static_cast<std::uint8_t>((((first * k) ^ last ^ s.size()) * k) >> 56);
+    }
+
+    inline void tag_keys::add(std::string_view tag, std::uint32_t slot)
+    {
+        if (tag.size() >= key_size)
+        {
+            longer.emplace_back(tag, slot);
+            return;
+        }
+        key k{};
+        std::memcpy(k.bytes, tag.data(), tag.size());
+        k.bytes[key_size - 1] = static_cast<unsigned char>(tag.size());
+
+        const auto count = keys.size();
+        fingerprints.resize((count / 16 + 1) * 16);
+        fingerprints[count] = fingerprint(tag);
+        keys.push_back(k);
+        slots.push_back(slot);
+    }
+
+    inline std::uint32_t tag_keys::find(std::string_view token) const
+    {
+        if (token.size() >= key_size)
+        {
+            for (const auto& [tag, slot] : longer)
+            {
+                if (tag == token)
+                {
+                    return slot;
+                }
+            }
+            return 0;
+        }
+
+        const auto matches = [&](std::size_t i)
+        {
+            const auto& k = keys[i].bytes;
+            return k[key_size - 1] == token.size() && std::memcmp(k, token.data(), token.size()) == 0;
+        };
+        const auto f = fingerprint(token);
+        const auto count = keys.size();
+#ifdef PX_HAS_SSE2
+        const auto needle = _mm_set1_epi8(static_cast<char>(f));
+        for (std::size_t block = 0; block < count; block += 16)
+        {
+            const auto candidates = _mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(fingerprints.data() + block)), needle);
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(candidates));
+            if (count - block < 16)
+            {
+                mask &= (1u << (count - block)) - 1;
+            }
+            for (; mask != 0; mask &= mask - 1)
+            {
+                const auto i = block + static_cast<std::size_t>(std::countr_zero(mask));
+                if (matches(i))
+                {
+                    return slots[i];
+                }
+            }
+        }
+#else
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (fingerprints[i] == f && matches(i))
+            {
+                return slots[i];
+            }
+        }
+#endif
+        return 0;
+    }
+
+    inline std::size_t tag_keys::heap_bytes() const
+    {
+        auto bytes = fingerprints.capacity() + keys.capacity() * sizeof(key) +
+            slots.capacity() * sizeof(std::uint32_t) + longer.capacity() * sizeof(longer[0]);
+        for (const auto& l : longer)
+        {
+            bytes += detail::heap_bytes(l.first);
+        }
+        return bytes;
+    }
+
+    // collects the arguments of an argv_array, each followed by a null
+    // character, converting values in place
+    class argv_builder
+    {
+    public:
+        void add(std::string_view s)
+        {
+            bytes.append(s);
+            bytes.push_back('\0');
+            ends.push_back(bytes.size());
+            longest = std::max(longest, s.size() + 1);
+        }
+
+        template <typename T>
+        void add_value(const T& t)
+        {
+            if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+            {
+                char buffer[64];
+                const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), t);
+                add(std::string_view(buffer, static_cast<std::size_t>(end - buffer)));
+            }
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            {
+                add(std::string_view(t));
+            }
+            else if constexpr (requires { std::string_view(t.native()); })
+            {
+                add(t.native());
+            }
+            else
+            {
+                add(format_value(t));
+            }
+        }
+
+        void pop_back()
+        {
+            ends.pop_back();
+            bytes.resize(ends.empty() ? 0 : ends.back());
+        }
+
+        std::size_t count() const
+        {
+            return ends.size();
+        }
+
+        std::string_view operator[](std::size_t i) const
+        {
+            const auto begin = (i == 0) ? 0 : ends[i - 1];
+            return std::string_view(bytes).substr(begin, ends[i] - begin - 1);
+        }
+
+        const std::string& get_bytes() const
+        {
+            return bytes;
+        }
+
+        // as the system counts them: the strings and a null terminated
+        // array of pointers
+        std::size_t size_in_bytes() const
+        {
+            return bytes.size() + (ends.size() + 1) * sizeof(char*);
+        }
+
+        std::size_t get_longest() const
+        {
+            return longest;
+        }
+
+    private:
+        std::string bytes;
+        std::vector<std::size_t> ends;
+        std::size_t longest = 0;
+    };
+
+    // an argument as a response file holds it, quoted when it would not
+    // read back as itself
+    inline std::string quote_response_argument(std::string_view s)
+    {
+        const auto plain = !s.empty() && s[0] != '\'' && s[0] != '"' &&
+            s.find_first_of(" \t\n\r") == std::string_view::npos;
+        if (plain)
+        {
+            return std::string(s);
+        }
+        const auto quote = (s.find('\'') == std::string_view::npos) ? "'" :
+            (s.find('"') == std::string_view::npos) ? "\"" : nullptr;
+        if (quote == nullptr)
+        {
+            throw std::runtime_error(concat({ "argument '", s, "' holds both quotes and cannot be written to a response file" }));
+        }
+        return concat({ quote, s, quote });
+    }
+
+    // throws when the arguments, not counting the program name, exceed the
+    // limits; costs one pass over them, and nothing without limits
+    template <typename range>
+    void check_limits(const range& args, const px::parse_limits& limits)
+    {
+        using limit = px::limit_exceeded::limit;
+        auto token_limits = limits;
+        token_limits.max_include_depth = px::parse_limits::unlimited;
+        if (token_limits == px::parse_limits{} || std::size(args) < 2)
+        {
+            return;
+        }
+        if (std::size(args) - 1 > limits.max_tokens)
+        {
+            throw px::limit_exceeded(limit::tokens, limits.max_tokens);
+        }
+
+        std::size_t bytes = 0;
+        std::size_t values = 0;
+        auto after_tag = false;
+        for (auto i = std::next(std::begin(args)); i != std::end(args); ++i)
+        {
+            const std::string_view arg(*i);
+            if (arg.size() > limits.max_value_length)
+            {
+                throw px::limit_exceeded(limit::value_length, limits.max_value_length);
+            }
+            bytes += arg.size();
+            if (bytes > limits.max_bytes)
+            {
+                throw px::limit_exceeded(limit::bytes, limits.max_bytes);
+            }
+
+            if (is_separator_tag(arg))
+            {
+                after_tag = false;
+            }
+            else if (is_tag(arg))
+            {
+                after_tag = true;
+                values = 0;
+            }
+            else if (after_tag && ++values > limits.max_values_per_argument)
+            {
+                throw px::limit_exceeded(limit::values_per_argument, limits.max_values_per_argument);
+            }
+        }
+    }
+
+    template <typename iterator>
+    auto find_invalid(const iterator& begin, const iterator& end)
+    {
+        return std::find_if_not(begin, end, [](auto& arg)
+        {
+            trace_span span(arg->get_name(), "validate");
+            return arg->is_valid();
+        });
+    }
+
+    template <typename iterator>
+    void throw_on_invalid(const iterator& begin, const iterator& end)
+    {
+        if (iterator invalid_arg = find_invalid(begin, end); invalid_arg != end)
+        {
+            throw std::runtime_error(concat({ "argument '", (*invalid_arg)->get_name(), "' invalid after parsing" }));
+        }
+    }
+}
+
+namespace px
+{
+    template <typename T>
+    const typename scalar<T>::value_type& scalar<T>::get_value() const
+    {
+        if (has_value())
+        {
+            return *value;
+        }
+        else
+        {
+            throw std::runtime_error("does not have value");
+        }
+    }
+
+    template <typename T>
+    bool scalar<T>::has_value() const
+    {
+        return value.has_value();
+    }
+
+    template <typename T>
+    template <typename iterator>
+    iterator scalar<T>::parse(const iterator& begin, const iterator& end)
+    {
+        value = detail::parse_scalar<T>(*begin);
+        return begin;
+    }
+
+    template <typename T>
+    void scalar<T>::assign(value_type v)
+    {
+        value = std::move(v);
+    }
+
+    template <typename iterator>
+    iterator scalar<std::string_view>::parse(const iterator& begin, const iterator&)
+    {
+        const std::string_view s(*begin);
+        if (from_file && s.size() > 1 && s[0] == '@')
+        {
+            file = std::make_unique<mapped_file>(std::string(s.substr(1)));
+            value = file->get_text();
+        }
+        else
+        {
+            value = s;
+        }
+        return begin;
+    }
+
+    inline const scalar<bool>::value_type& scalar<bool>::get_value() const
+    {
+        return value;
+    }
+
+    inline bool scalar<bool>::has_value() const
+    {
+        return true;
+    }
+
+    template <typename iterator>
+    iterator scalar<bool>::parse(const iterator& begin, const iterator& end)
+    {
+        value = true;
+        return begin;
+    }
+
+    template <typename T>
+    bool multi_scalar<T>::has_value() const
+    {
+        return !std::empty(value);
+    }
+
+    template <typename T>
+    const typename multi_scalar<T>::value_type& multi_scalar<T>::get_value() const
+    {
+        return value;
+    }
+
+    template <typename T>
+    template <typename iterator>
+    iterator multi_scalar<T>::parse(const iterator& begin, const iterator& end)
+    {
+        auto i = begin;
+        if (std::distance(begin, end) > 0)
+        {
+            for (; i != end && !detail::is_tag(*i); ++i)
+            {
+                if (expand)
+                {
+                    expand(*i, value);
+                }
+                else
+                {
+                    value.push_back(detail::parse_scalar<T>(*i));
+                }
+            }
+
+            --i;
+        }
+
+        return i;
+    }
+
+    template <typename T>
+    void multi_scalar<T>::assign(value_type v)
+    {
+        value = std::move(v);
+    }
+
+    template <typename T>
+    void multi_scalar<T>::set_expander(expander e)
+    {
+        expand = std::move(e);
+    }
+
+    template <typename Derived, typename core>
+    inline Derived& argument<Derived, core>::set_description(std::string_view d)
+    {
+        core::store_description(d);
+        return *this_as_derived();
+    }
+
+    template <typename T>
+    positional_argument<T>::positional_argument(std::string_view n) :
+	positional_argument<T>::base(n)
+    {
+    }
+    
+    template <typename T>
+    positional_argument<T>& positional_argument<T>::bind(positional_argument<T>::value_type* t)
+    {
+        bound_variable = t;
+        return *this;
+    }
+
+    template <typename T>
+    positional_argument<T>& positional_argument<T>::set_validator(validation_function f)
+    {
+        validator = std::move(f);
+        base::store_validator_help({});
+        return *this;
+    }
+
+    template <typename T>
+    template <detail::self_describing F>
+    positional_argument<T>& positional_argument<T>::set_validator(F f)
+    {
+        base::store_validator_help(f.describe());
+        validator = std::move(f);
+        return *this;
+    }
+
+    template <typename T>
+    void positional_argument<T>::serialize(detail::argv_builder& b) const
+    {
+        if (value.has_value())
+        {
+            b.add_value(*value);
+        }
+    }
+
+    template <typename T>
+    void positional_argument<T>::measure(memory_breakdown::argument_usage& usage) const
+    {
+        base::measure_metadata(usage);
+        usage.object_bytes = sizeof(*this);
+        usage.callables.inline_bytes += sizeof(validator);
+        usage.values = { sizeof(value), value.has_value() ? detail::heap_bytes(*value) : 0 };
+        if (bound_variable != nullptr)
+        {
+            usage.bound = { sizeof(value_type), detail::heap_bytes(*bound_variable) };
+        }
+    }
+
+    template <typename T>
+    bool positional_argument<T>::has_value() const
+    {
+        return value.has_value();
+    }
+
+    template <typename T>
+    bool positional_argument<T>::validate() const
+    {
+        return validator(*value);
+    }
+
+    template <typename T>
+    const typename positional_argument<T>::value_type& positional_argument<T>::get_value() const
+    {
+        if (value.has_value())
+        {
+            return *value;
+        }
+        else
+        {
+            throw std::runtime_error(detail::concat({ "getting value from invalid argument '", base::get_name(), "'" }));
+        }
+    }
+
+    template <typename T>
+    argv_iterator
+        positional_argument<T>::parse(const argv_iterator& begin,
+            const argv_iterator& end)
+    {
+        {
+            detail::trace_span span(base::get_name(), "convert");
+            value = detail::parse_scalar<value_type>(*begin);
+        }
+        if (bound_variable != nullptr)
+        {
+            detail::trace_span span(base::get_name(), "bind");
+            *bound_variable = *value;
+        }
+        return begin;
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_alternate_tag(std::string_view t)
+    {
+        base::store_alternate_tag(t);
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>::tag_argument(std::string_view n, std::string_view t) :
+        base(n, t, std::is_same_v<T, bool>)
+    {
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_value_from_file(bool f)
+        requires std::is_same_v<storage, scalar<std::string_view>>
+    {
+        value.set_value_from_file(f);
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_expander(typename multi_scalar<T>::expander e)
+        requires std::is_same_v<storage, multi_scalar<T>>
+    {
+        value.set_expander(std::move(e));
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::bind(value_type* t)
+    {
+        bound_variable = t;
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    bool tag_argument<T, storage>::is_required() const requires (!std::is_same_v<T, bool>)
+    {
+        return base::is_required();
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_required(bool r) requires (!std::is_same_v<T, bool>)
+    {
+        base::store_required(r);
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_validator(validation_function f) requires (!std::is_same_v<T, bool>)
+    {
+        validator = std::move(f);
+        base::store_validator_help({});
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    template <detail::self_describing F>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_validator(F f) requires (!std::is_same_v<T, bool>)
+    {
+        base::store_validator_help(f.describe());
+        validator = std::move(f);
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    const typename tag_argument<T, storage>::value_type& tag_argument<T, storage>::get_value() const
+    {
+        if (!base::is_valid())
+        {
+            throw std::runtime_error(detail::concat({ "getting value from invalid argument '", base::get_name(), "'" }));
+        }
+        return value.get_value();
+    }
+
+    template <typename T, typename storage>
+    bool tag_argument<T, storage>::has_value() const
+    {
+        return value.has_value();
+    }
+
+    template <typename T, typename storage>
+    bool tag_argument<T, storage>::validate() const
+    {
+        return validator(value.get_value());
+    }
+
+    template <typename T, typename storage>
+    argv_iterator
+        tag_argument<T, storage>::convert(const argv_iterator& begin,
+            const argv_iterator& end)
+    {
+        [[maybe_unused]] const auto before = [&]
+        {
+            if constexpr (std::is_same_v<storage, multi_scalar<T>>)
+            {
+                return value.get_value().size();
+            }
+            else
+            {
+                return 0;
+            }
+        }();
+        const auto i = [&]
+        {
+            detail::trace_span span(base::get_name(), "convert");
+            return value.parse(begin, end);
+        }();
+        if (bound_variable != nullptr)
+        {
+            detail::trace_span span(base::get_name(), "bind");
+            if constexpr (std::is_same_v<storage, multi_scalar<T>>)
+            {
+                // only the values of this occurrence are copied, so binding
+                // an argument given k times is linear rather than quadratic
+                const auto& values = value.get_value();
+                if (bound_variable->size() == before)
+                {
+                    bound_variable->insert(bound_variable->end(), values.begin() + before, values.end());
+                }
+                else
+                {
+                    *bound_variable = values;
+                }
+            }
+            else
+            {
+                *bound_variable = value.get_value();
+            }
+        }
+        return i;
+    }
+
+    template <typename T, typename storage>
+    tag_argument<T, storage>& tag_argument<T, storage>::set_default(std::function<value_type()> f)
+        requires (!std::is_same_v<T, bool>)
+    {
+        default_value = std::move(f);
+        return *this;
+    }
+
+    template <typename T, typename storage>
+    void tag_argument<T, storage>::apply_default()
+    {
+        if constexpr (!std::is_same_v<T, bool>)
+        {
+            if (default_value && !value.has_value())
+            {
+                detail::trace_span span(base::get_name(), "default");
+                value.assign(default_value());
+                if (bound_variable != nullptr)
+                {
+                    *bound_variable = value.get_value();
+                }
+            }
+        }
+    }
+
+    template <typename T, typename storage>
+    void tag_argument<T, storage>::measure(memory_breakdown::argument_usage& usage) const
+    {
+        base::measure_metadata(usage);
+        usage.object_bytes = sizeof(*this);
+        usage.callables.inline_bytes += sizeof(validator) + sizeof(default_value);
+        usage.values = { sizeof(value), value.has_value() ? detail::heap_bytes(value.get_value()) : 0 };
+        if constexpr (std::is_same_v<storage, multi_scalar<T>>)
+        {
+            // the expander is held by the storage
+            usage.callables.inline_bytes += sizeof(typename multi_scalar<T>::expander);
+            usage.values.inline_bytes -= sizeof(typename multi_scalar<T>::expander);
+        }
+        if (bound_variable != nullptr)
+        {
+            usage.bound = { sizeof(value_type), detail::heap_bytes(*bound_variable) };
+        }
+    }
+
+    template <typename T, typename storage>
+    void tag_argument<T, storage>::serialize(detail::argv_builder& b) const
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            if (value.get_value())
+            {
+                b.add(base::get_tag());
+            }
+        }
+        else if (value.has_value())
+        {
+            b.add(base::get_tag());
+            if constexpr (detail::is_vector<value_type>::value)
+            {
+                for (const auto& v : value.get_value())
+                {
+                    b.add_value(v);
+                }
+            }
+            else
+            {
+                b.add_value(value.get_value());
+            }
+        }
+    }
+
+    template <typename T, typename storage>
+    std::string tag_argument<T, storage>::describe_default() const
+    {
+        return default_value ? detail::format_value(default_value()) : std::string();
+    }
+
+    template <typename T>
+    inline positional_argument<T>& command_line::add_positional_argument(std::string_view name)
+    {
+        auto arg = std::make_unique<positional_argument<T>>(name);
+	auto& ref = *arg;
+        positional_arguments.push_back(std::move(arg));
+        index_name(ref, detail::type_id_of<positional_argument<T>>());
+	return ref;
+    }
+
+    template <typename T>
+    tag_argument<T>& command_line::add_value_argument(std::string_view name, std::string_view tag)
+    {
+        prevent_tag_args_after_positional_args();
+        auto arg = std::make_unique<tag_argument<T>>(name, tag);
+	auto& ref = *arg;
+        arguments.push_back(std::move(arg));
+        index_name(ref, detail::type_id_of<tag_argument<T>>());
+	return ref;
+    }
+
+    template <typename T>
+    tag_argument<T, multi_scalar<T>>& command_line::add_multi_value_argument(std::string_view name, std::string_view tag)
+    {
+        prevent_tag_args_after_positional_args();
+        auto arg = std::make_unique<tag_argument<T, multi_scalar<T>>>(name, tag);
+	auto& ref = *arg;
+        arguments.push_back(std::move(arg));
+        index_name(ref, detail::type_id_of<tag_argument<T, multi_scalar<T>>>());
+	return ref;
+    }
+
+    template <typename T>
+    const T& command_line::get(std::string_view n) const
+    {
+        return get<T>(name_key(n));
+    }
+
+    template <typename T>
+    const T& command_line::get(name_key key) const
+    {
+        const auto& n = find_name(key);
+        if constexpr (detail::is_vector<T>::value)
+        {
+            using element_type = typename T::value_type;
+            if (n.type == detail::type_id_of<tag_argument<element_type, multi_scalar<element_type>>>())
+            {
+                return static_cast<const tag_argument<element_type, multi_scalar<element_type>>*>(n.argument)->get_value();
+            }
+        }
+        else if (n.type == detail::type_id_of<tag_argument<T>>())
+        {
+            return static_cast<const tag_argument<T>*>(n.argument)->get_value();
+        }
+        else if (n.type == detail::type_id_of<positional_argument<T>>())
+        {
+            return static_cast<const positional_argument<T>*>(n.argument)->get_value();
+        }
+        throw std::logic_error(detail::concat({ "argument '", key.get_name(), "' does not have the requested type" }));
+    }
+
+#if !defined(PX_STATIC) || defined(PX_STATIC_IMPLEMENTATION)
+    PX_API limit_exceeded::limit_exceeded(limit l, std::size_t maximum) :
+        std::runtime_error([l, maximum]
+            {
+                const auto n = std::to_string(maximum);
+                switch (l)
+                {
+                case limit::tokens:
+                    return detail::concat({ "more than ", n, " arguments" });
+                case limit::bytes:
+                    return detail::concat({ "arguments longer than ", n, " bytes in total" });
+                case limit::value_length:
+                    return detail::concat({ "argument longer than ", n, " bytes" });
+                case limit::values_per_argument:
+                    return detail::concat({ "more than ", n, " values for one argument" });
+                case limit::include_depth:
+                    return detail::concat({ "response files nested more than ", n, " deep" });
+                }
+                return std::string("limit exceeded");
+            }()),
+        exceeded(l)
+    {
+    }
+
+    PX_API limit_exceeded::limit limit_exceeded::which() const
+    {
+        return exceeded;
+    }
+
+    PX_API mapped_file::mapped_file(const std::string& path, std::size_t max_bytes)
+    {
+#ifdef PX_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat status{};
+        if (fd >= 0 && ::fstat(fd, &status) == 0 && status.st_size > 0)
+        {
+            const auto size = static_cast<std::size_t>(status.st_size);
+            if (size > max_bytes)
+            {
+                ::close(fd);
+                throw limit_exceeded(limit_exceeded::limit::bytes, max_bytes);
+            }
+            if (auto* m = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); m != MAP_FAILED)
+            {
+                ::madvise(m, size, MADV_WILLNEED);
+                mapping = m;
+                text = std::string_view(static_cast<const char*>(m), size);
+                ::close(fd);
+                return;
+            }
+        }
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+#endif
+        auto read = detail::read_file(path);
+        if (!read)
+        {
+            throw std::runtime_error(detail::concat({ "could not read file '", path, "'" }));
+        }
+        if (read->size() > max_bytes)
+        {
+            throw limit_exceeded(limit_exceeded::limit::bytes, max_bytes);
+        }
+        contents = std::move(*read);
+        text = contents;
+    }
+
+    PX_API mapped_file::~mapped_file()
+    {
+#ifdef PX_HAS_MMAP
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, text.size());
+        }
 #endif
-#include <string_view>
-#include <vector>
-#include <iterator>
+    }
 
-namespace detail
-{
-    auto pad_right(std::string_view s, decltype(s.size()) n)
+    PX_API std::string_view mapped_file::get_text() const
     {
-	constexpr decltype(s.size()) zero {0};
-        return std::string(s).append(std::max(zero, n - s.size()), ' ');
+        return text;
     }
 
-    template <typename T>
-    auto parse_scalar(const std::string& s)
+    PX_API bool scalar<std::string_view>::has_value() const
     {
-        if constexpr (std::is_same_v<std::string, T>)
+        return value.has_value();
+    }
+
+    PX_API const scalar<std::string_view>::value_type& scalar<std::string_view>::get_value() const
+    {
+        if (has_value())
         {
-            return s;
+            return *value;
         }
         else
         {
-            std::istringstream stream(s);
-            T t;
-            stream >> t;
-            if (!stream.eof() || stream.fail())
-            {
-                throw std::runtime_error("could not parse from '" + s + "'");
-            }
-            return t;
+            throw std::runtime_error("does not have value");
         }
     }
 
-    auto is_separator_tag(std::string_view s)
+    PX_API void scalar<std::string_view>::assign(value_type v)
     {
-        return s.size() == 2 && s[0] == '-' && s[1] == '-';
+        value = v;
     }
 
-    auto is_short_tag(std::string_view s)
+    PX_API void scalar<std::string_view>::set_value_from_file(bool f)
     {
-        return (s.size() > 1 && s[0] == '-' && !std::isdigit(s[1]));
+        from_file = f;
     }
 
-    auto is_alternate_tag(std::string_view s)
+    PX_API string_sink::string_sink(std::string& str) :
+        s(str)
     {
-        return (s.size() > 2 && s[0] == '-' && s[1] == '-' && !std::isdigit(s[2]));
     }
 
-    auto is_tag(const std::string& s)
+    PX_API void string_sink::write(std::string_view text)
     {
-        return !s.empty() && !is_separator_tag(s) &&
-             (is_short_tag(s) || is_alternate_tag(s));
+        s.append(text);
     }
 
-    template <typename iterator>
-    auto find_invalid(const iterator& begin, const iterator& end)
+    PX_API file_sink::file_sink(std::FILE* f) :
+        file(f)
     {
-        return std::find_if_not(begin, end, [](auto& arg) { return arg->is_valid(); });
     }
 
-    template <typename iterator>
-    void throw_on_invalid(const iterator& begin, const iterator& end)
+    PX_API void file_sink::write(std::string_view text)
     {
-        if (iterator invalid_arg = find_invalid(begin, end); invalid_arg != end)
-        {
-            throw std::runtime_error("argument '" + (*invalid_arg)->get_name() + "' invalid after parsing");
-        }
+        std::fwrite(text.data(), 1, text.size(), file);
     }
-}
 
-namespace px
-{
-    template <typename T>
-    class scalar
+#if __has_include(<unistd.h>)
+    PX_API fd_sink::fd_sink(int f) :
+        fd(f)
     {
-    public:
-        using value_type = T;
-        bool has_value() const;
-        const value_type& get_value() const;
-        template <typename iterator>
-        iterator parse(const iterator& begin, const iterator& end);
+    }
 
-    private:
-        std::optional<value_type> value = std::nullopt;
-    };
+    PX_API void fd_sink::write(std::string_view text)
+    {
+        while (!text.empty())
+        {
+            const auto written = ::write(fd, text.data(), text.size());
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "writing help");
+            }
+            text.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+#endif
 
-    template <>
-    class scalar<bool>
+#ifndef PX_NO_IOSTREAM
+    PX_API ostream_sink::ostream_sink(std::ostream& stream) :
+        o(stream)
     {
-    public:
-        using value_type = bool;
-        bool has_value() const;
-        const value_type& get_value() const;
-        template <typename iterator>
-        iterator parse(const iterator& begin, const iterator& end);
-    private:
-        bool value = false;
-    };
+    }
 
-    template <typename T>
-    class multi_scalar
+    PX_API void ostream_sink::write(std::string_view text)
     {
-    public:
-        using value_type = std::vector<T>;
-        bool has_value() const;
-        const value_type& get_value() const;
+        o.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+#endif
 
-        template <typename iterator>
-        iterator parse(const iterator& begin, const iterator& end);
+    PX_API argument_core::argument_core(std::string_view n) :
+        name(n)
+    {
+    }
 
-    private:
-        value_type value;
-    };
+    PX_API const metadata_string& argument_core::get_name() const
+    {
+        return name;
+    }
 
-#ifdef PX_HAS_SPAN
-    using argv_iterator = std::span<const std::string>::iterator;
-#else
-    using argv_iterator = std::vector<std::string>::const_iterator;
-#endif
-    class iargument
+    PX_API const metadata_string& argument_core::get_description() const
     {
-    public:
-        virtual ~iargument() = default;
-        virtual void print_help(std::ostream&) const = 0;
-        virtual argv_iterator parse(const argv_iterator&, const argv_iterator&) = 0;
-        virtual bool is_valid() const = 0;
+        return description;
+    }
 
-        virtual const std::string& get_name() const = 0;
-        virtual const std::string& get_description() const = 0;
-    };
+    PX_API void argument_core::store_description(std::string_view d)
+    {
+        description = d;
+    }
 
-    template <typename Derived>
-    class argument : public iargument
+    PX_API const std::string& argument_core::get_validator_help() const
     {
-    public:
-        argument(std::string_view n);
-        virtual ~argument() = default;
+        return validator_help;
+    }
 
-        const std::string& get_name() const override;
-        const std::string& get_description() const override;
-        Derived& set_description(std::string_view d);
+    PX_API void argument_core::store_validator_help(std::string h)
+    {
+        validator_help = std::move(h);
+    }
 
-    private:
-        Derived* this_as_derived() { return reinterpret_cast<Derived*>(this); }
-        std::string name;
-        std::string description;
-    };
+    PX_API void argument_core::measure_metadata(memory_breakdown::argument_usage& usage) const
+    {
+        usage.name = name;
+        usage.metadata.inline_bytes += sizeof(name) + sizeof(description) + sizeof(validator_help);
+        usage.metadata.heap_bytes += detail::heap_bytes(name) + detail::heap_bytes(description) +
+            detail::heap_bytes(validator_help);
+    }
 
-    template <typename T>
-    class positional_argument : public argument<positional_argument<T>>
+    PX_API void positional_argument_core::print_help(help_sink& o) const
     {
-    public:
-        using value_type = T;
-        using validation_function = std::function<bool(const value_type&)>;
-        using base = argument<positional_argument<T>>;
+        o.write(detail::concat({ "   ", get_name(), " ", get_description(), detail::format_validator_help(get_validator_help()), "\n" }));
+    }
 
-        positional_argument(std::string_view n);
-        virtual ~positional_argument<T>() = default;
+    PX_API bool positional_argument_core::is_valid() const
+    {
+        return has_value() && validate();
+    }
 
-        void print_help(std::ostream&) const override;
-        argv_iterator parse(const argv_iterator&, const argv_iterator&) override;
-        bool is_valid() const override;
+    PX_API void positional_argument_core::apply_default()
+    {
+    }
 
-        const value_type& get_value() const;
-        positional_argument<T>& bind(T*);
+    PX_API tag_argument_core::tag_argument_core(std::string_view n, std::string_view t, bool is_flag) :
+        argument_core(n),
+        tag(t),
+        flag(is_flag)
+    {
+    }
 
-        positional_argument<T>& set_validator(validation_function);
+    PX_API bool tag_argument_core::matches(std::string_view s) const
+    {
+        return (!tag.empty() && tag == s) || (!alternate_tag.empty() && alternate_tag == s);
+    }
 
-    private:
-        std::optional<value_type> value = std::nullopt;
-        value_type* bound_variable = nullptr;
-        validation_function validator = [](const auto&) { return true; };
-    };
+    PX_API const metadata_string& tag_argument_core::get_tag() const
+    {
+        return tag;
+    }
 
-    template <typename T, typename storage = scalar<T>>
-    class tag_argument : public argument<tag_argument<T, storage>>
+    PX_API const metadata_string& tag_argument_core::get_alternate_tag() const
     {
-    public:
-        using value_type = typename storage::value_type;
-        using validation_function = std::function<bool(const value_type&)>;
-        using base = argument<tag_argument<T, storage>>;
+        return alternate_tag;
+    }
 
-        tag_argument(std::string_view n, std::string_view t);
-        virtual ~tag_argument() = default;
+    PX_API void tag_argument_core::store_alternate_tag(std::string_view t)
+    {
+        alternate_tag = t;
+        if (tags_changed != nullptr)
+        {
+            *tags_changed = true;
+        }
+    }
 
-        const value_type& get_value() const;
-        tag_argument<T, storage>& bind(value_type*);
+    PX_API void tag_argument_core::measure_metadata(memory_breakdown::argument_usage& usage) const
+    {
+        argument_core::measure_metadata(usage);
+        usage.metadata.inline_bytes += sizeof(tag) + sizeof(alternate_tag);
+        usage.metadata.heap_bytes += detail::heap_bytes(tag) + detail::heap_bytes(alternate_tag);
+    }
 
-        template <typename U = T, typename = std::enable_if<!std::is_same_v<U, bool>>>
-        bool is_required() const;
-        template <typename U = T, typename = std::enable_if<!std::is_same_v<U, bool>>>
-        tag_argument<T, storage>& set_required(bool);
+    PX_API bool tag_argument_core::is_required() const
+    {
+        return required;
+    }
 
-        template <typename U = T, typename = std::enable_if<!std::is_same_v<U, bool>>>
-        tag_argument<T, storage>& set_validator(validation_function f);
-        bool is_valid() const override;
+    PX_API void tag_argument_core::store_required(bool r)
+    {
+        required = r;
+    }
 
-        void print_help(std::ostream&) const override;
-        argv_iterator parse(const argv_iterator&, const argv_iterator&) override;
+    PX_API void tag_argument_core::print_help(help_sink& o) const
+    {
+        o.write(detail::format_tag_help(tag, alternate_tag, required, get_description(), get_validator_help(), describe_default()));
+    }
 
-        const std::string& get_tag() const;
-        const std::string& get_alternate_tag() const;
-        tag_argument<T, storage>& set_alternate_tag(std::string_view);
+    PX_API bool tag_argument_core::is_valid() const
+    {
+        if (has_value())
+        {
+            return validate();
+        }
+        else return !required;
+    }
 
-    private:
-        bool matches(std::string_view) const;
-        std::string tag;
-        std::string alternate_tag;
-        storage value;
-        value_type* bound_variable = nullptr;
-        bool required = false;
-        validation_function validator = [](const auto&) { return true; };
-    };
+    PX_API argv_iterator
+        tag_argument_core::parse(const argv_iterator& begin,
+            const argv_iterator& end)
+    {
+        if (std::distance(begin, end) >= 1 && matches(*begin))
+        {
+            if (flag)
+            {
+                return convert(begin, end);
+            }
+            else if (std::next(begin) == end)
+            {
+                throw std::runtime_error(detail::concat({ "argument '", get_name(), "' requires a value" }));
+            }
+            return convert(std::next(begin), end);
+        }
+        else
+        {
+            return begin;
+        }
+    }
 
-    class command_line
+    PX_API command_line::command_line(std::string_view program_name) :
+        name(program_name)
     {
-    public:
-        command_line(std::string_view program_name);
+    }
 
-        tag_argument<bool, scalar<bool>>& add_flag_argument(std::string_view, std::string_view);
-        template <typename T>
-        tag_argument<T>& add_value_argument(std::string_view, std::string_view);
-        template <typename T>
-        tag_argument<T, multi_scalar<T>>& add_multi_value_argument(std::string_view name, std::string_view);
-        template <typename T>
-        positional_argument<T>& add_positional_argument(std::string_view);
+    PX_API tag_argument<bool, scalar<bool>>& command_line::add_flag_argument(std::string_view name, std::string_view tag)
+    {
+        prevent_tag_args_after_positional_args();
+        auto arg = std::make_unique<tag_argument<bool, scalar<bool>>>(name, tag);
+	auto& ref = *arg;
+        arguments.push_back(std::move(arg));
+        index_name(ref, detail::type_id_of<tag_argument<bool, scalar<bool>>>());
+	return ref;
+    }
 
-        void print_help(std::ostream&);
 #ifdef PX_HAS_SPAN
-        void parse(std::span<const std::string>);
+    PX_API void command_line::parse(std::span<const std::string> args)
 #else
-        void parse(const std::vector<std::string>&);
+    PX_API void command_line::parse(const std::vector<std::string>& args)
 #endif
-        void parse(int argc, char** argv);
+    {
+#ifdef PX_TRACE
+        detail::tracing_scope tracing(tracer);
+#endif
+        if (response_files && args.size() == 2 && args[1].size() > 1 && args[1][0] == '@')
+        {
+            parse_response_file(args[0], args[1].substr(1));
+            return;
+        }
+        parse_arguments(args);
+    }
 
-    private:
-        void prevent_tag_args_after_positional_args();
+    PX_API void command_line::parse_response_file(std::string_view program, const std::string& path)
+    {
+        if (limits.max_include_depth == 0)
+        {
+            throw limit_exceeded(limit_exceeded::limit::include_depth, limits.max_include_depth);
+        }
 
-        std::string name;
-        std::string description;
-        std::vector<std::unique_ptr<iargument>> arguments;
-        std::vector<std::unique_ptr<iargument>> positional_arguments;
-    };
+        std::vector<std::string_view> tokens;
+        {
+            detail::trace_span span("response file", "px");
+            // a file larger than the byte limit is rejected before it is read
+            const mapped_file file(path, limits.max_bytes);
+            const auto max_tokens = limits.max_tokens;
+            auto within = false;
+            try
+            {
+                within = detail::tokenize_preset(file.get_text(), tokens,
+                    (max_tokens == parse_limits::unlimited) ? max_tokens : max_tokens + 1);
+            }
+            catch (const std::runtime_error& e)
+            {
+                throw std::runtime_error(detail::concat({ e.what(), " of response file '", path, "'" }));
+            }
+            if (!within)
+            {
+                throw limit_exceeded(limit_exceeded::limit::tokens, max_tokens);
+            }
 
-    template <typename T>
-    const typename scalar<T>::value_type& scalar<T>::get_value() const
+            // the program name may be in given, so it is copied first
+            std::vector<std::string> expanded;
+            expanded.reserve(tokens.size() + 1);
+            expanded.emplace_back(program);
+            expanded.insert(expanded.end(), tokens.begin(), tokens.end());
+            given = std::move(expanded);
+        }
+        parse_arguments(given);
+    }
+
+#ifdef PX_HAS_SPAN
+    PX_API void command_line::parse_arguments(std::span<const std::string> args)
     {
-        if (has_value())
+        const auto end = args.end();
+        auto argv = args.begin();
+#else
+    PX_API void command_line::parse_arguments(const std::vector<std::string>& args)
+    {
+        const auto end = args.cend();
+        auto argv = args.cbegin();
+#endif
+        detail::trace_span parsing("parse", "px");
         {
-            return *value;
+            detail::trace_span span("limits", "px");
+            detail::check_limits(args, limits);
         }
-        else
+
+	const auto parse_all = [](auto& args, auto& argv, const auto& end)
+	{
+	    std::for_each(args.begin(), args.end(), 
+			  [&argv, &end](auto& arg) { argv = arg->parse(argv, end); });
+	    return argv;
+	};
+	
+        if (prepared == dispatch_strategy::automatic || prepared_arguments != arguments.size() ||
+            !tags_changed || *tags_changed)
         {
-            throw std::runtime_error("does not have value");
+            prepare_dispatch();
+        }
+
+        if (std::distance(argv, end) > 0)
+        {
+            detail::trace_span span("dispatch", "px");
+	    auto separator_found = false;
+	    ++argv;
+            for (; argv != end && !separator_found; ++argv)
+            {
+		separator_found = detail::is_separator_tag(*argv);
+                if (!separator_found)
+                {
+		    if (repeated_tags)
+		    {
+			argv = parse_all(arguments, argv, end);
+		    }
+		    else if (auto* arg = find_tag(*argv))
+		    {
+			argv = arg->parse(argv, end);
+		    }
+		}
+            }
+
+            if (!positional_arguments.empty())
+            {
+		for (argv = (!separator_found) ? std::next(args.begin()) : argv;
+		     argv != end; ++argv)
+		{
+		    argv = parse_all(positional_arguments, argv, end);
+		}
+            }
+        }
+
+        {
+            detail::trace_span span("defaults", "px");
+            for (auto& arg : arguments)
+            {
+                arg->apply_default();
+            }
         }
+        detail::trace_span span("validation", "px");
+        detail::throw_on_invalid(arguments.cbegin(), arguments.cend());
+        detail::throw_on_invalid(positional_arguments.cbegin(), positional_arguments.cend());
     }
 
-    template <typename T>
-    bool scalar<T>::has_value() const
+    PX_API void command_line::parse(int argc, char** argv)
     {
-        return value.has_value();
+#ifdef PX_TRACE
+        detail::tracing_scope tracing(tracer);
+#endif
+        {
+            detail::trace_span span("copy arguments", "px");
+            given.assign(argv, argv + argc);
+        }
+        parse(given);
     }
 
-    template <typename T>
-    template <typename iterator>
-    iterator scalar<T>::parse(const iterator& begin, const iterator& end)
+#ifdef PX_TRACE
+    PX_API void command_line::set_tracer(parse_tracer* t)
     {
-        value = detail::parse_scalar<T>(*begin);
-        return begin;
+        tracer = t;
     }
 
-    inline const scalar<bool>::value_type& scalar<bool>::get_value() const
+    PX_API parse_tracer::parse_tracer(std::size_t capacity) :
+        spans(std::max<std::size_t>(1, capacity))
     {
-        return value;
     }
 
-    inline bool scalar<bool>::has_value() const
+    PX_API std::size_t parse_tracer::size() const
     {
-        return true;
+        return std::min(recorded, spans.size());
     }
 
-    template <typename iterator>
-    iterator scalar<bool>::parse(const iterator& begin, const iterator& end)
+    PX_API std::size_t parse_tracer::get_dropped() const
     {
-        value = true;
-        return begin;
+        return recorded - size();
     }
 
-    template <typename T>
-    bool multi_scalar<T>::has_value() const
+    PX_API void parse_tracer::clear()
     {
-        return !std::empty(value);
+        next = 0;
+        recorded = 0;
     }
 
-    template <typename T>
-    const typename multi_scalar<T>::value_type& multi_scalar<T>::get_value() const
+    PX_API void parse_tracer::record(std::string_view name, const char* category, std::int64_t begin, std::int64_t end)
     {
-        return value;
+        spans[next] = { name, category, begin, end - begin };
+        next = (next + 1 == spans.size()) ? 0 : next + 1;
+        ++recorded;
     }
 
-    template <typename T>
-    template <typename iterator>
-    iterator multi_scalar<T>::parse(const iterator& begin, const iterator& end)
+    PX_API void parse_tracer::write(help_sink& o) const
     {
-        auto i = begin;
-        if (std::distance(begin, end) > 0)
+        const auto origin = std::chrono::duration_cast<std::chrono::nanoseconds>(epoch.time_since_epoch()).count();
+        const auto microseconds = [](std::int64_t ns)
         {
-            for (; i != end && !detail::is_tag(*i); ++i)
+            char buffer[32];
+            const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(ns) / 1000.0, std::chars_format::fixed, 3);
+            return std::string(buffer, end);
+        };
+        const auto escaped = [](std::string_view s)
+        {
+            std::string e;
+            for (const auto c : s)
             {
-                value.push_back(detail::parse_scalar<T>(*i));
+                if (c == '"' || c == '\\')
+                {
+                    e += '\\';
+                    e += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    constexpr char hex[] = "0123456789abcdef";
+                    e += "\\u00";
+                    e += hex[(c >> 4) & 0xf];
+                    e += hex[c & 0xf];
+                }
+                else
+                {
+                    e += c;
+                }
             }
+            return e;
+        };
 
-            --i;
+        // spans end in order, so the oldest kept is the next to overwrite
+        o.write("{\"traceEvents\":[");
+        const auto first = (recorded > spans.size()) ? next : 0;
+        for (std::size_t k = 0; k < size(); ++k)
+        {
+            const auto& span = spans[(first + k) % spans.size()];
+            o.write(detail::concat({ (k == 0) ? "\n" : ",\n",
+                "{\"name\":\"", escaped(span.name), "\",\"cat\":\"", span.category,
+                "\",\"ph\":\"X\",\"ts\":", microseconds(span.begin - origin),
+                ",\"dur\":", microseconds(span.duration), ",\"pid\":1,\"tid\":1}" }));
         }
-
-        return i;
+        o.write("\n],\"displayTimeUnit\":\"ns\"}\n");
     }
+#endif
 
-    template <typename T>
-    inline argument<T>::argument(std::string_view n) :
-        name(n)
+    PX_API argv_array command_line::to_argv(std::string_view program,
+        const std::function<bool(std::string_view)>& filter, std::size_t max_bytes) const
     {
-    }
+        detail::argv_builder b;
+        b.add(program);
+        const auto serialize = [&](const auto& args)
+        {
+            for (const auto& arg : args)
+            {
+                if (!filter || filter(arg->get_name()))
+                {
+                    arg->serialize(b);
+                }
+            }
+        };
+        serialize(arguments);
+        b.add("--");
+        serialize(positional_arguments);
+        if (b[b.count() - 1] == "--")
+        {
+            b.pop_back();
+        }
 
-    template <typename T>
-    inline const std::string& argument<T>::get_name() const
-    {
-        return name;
+#ifdef __linux__
+        // the kernel also limits each argument, to 32 pages
+        constexpr std::size_t max_argument = 32 * 4096;
+#else
+        constexpr std::size_t max_argument = std::numeric_limits<std::size_t>::max();
+#endif
+        if (b.size_in_bytes() <= max_bytes && b.get_longest() <= max_argument)
+        {
+            return argv_array(b);
+        }
+
+#if __has_include(<unistd.h>)
+        const auto* directory = std::getenv("TMPDIR");
+        std::string path = detail::concat({ (directory != nullptr && *directory != '\0') ? directory : "/tmp", "/px-argv-XXXXXX" });
+        const auto fd = ::mkstemp(path.data());
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "creating response file");
+        }
+        std::string text;
+        try
+        {
+            for (std::size_t i = 1; i < b.count(); ++i)
+            {
+                text += detail::quote_response_argument(b[i]);
+                text += '\n';
+            }
+        }
+        catch (...)
+        {
+            ::close(fd);
+            std::remove(path.c_str());
+            throw;
+        }
+        for (std::string_view rest(text); !rest.empty();)
+        {
+            const auto written = ::write(fd, rest.data(), rest.size());
+            if (written < 0 && errno != EINTR)
+            {
+                const auto error = errno;
+                ::close(fd);
+                std::remove(path.c_str());
+                throw std::system_error(error, std::generic_category(), "writing response file");
+            }
+            rest.remove_prefix(static_cast<std::size_t>(std::max<decltype(written)>(written, 0)));
+        }
+        ::close(fd);
+
+        detail::argv_builder spilled;
+        spilled.add(program);
+        spilled.add(detail::concat({ "@", path }));
+        return argv_array(spilled, std::move(path));
+#else
+        throw std::runtime_error("arguments do not fit on the command line");
+#endif
     }
 
-    template <typename T>
-    inline T& argument<T>::set_description(std::string_view d)
+    PX_API memory_breakdown command_line::memory_usage() const
     {
-        description = d;
-        return *this_as_derived();
+        memory_breakdown usage;
+        usage.schema.inline_bytes = sizeof(*this);
+        usage.schema.heap_bytes = detail::heap_bytes(name) + detail::heap_bytes(description) + detail::heap_bytes(given) +
+            (arguments.capacity() + positional_arguments.capacity()) * sizeof(std::unique_ptr<iargument>) +
+            named.capacity() * sizeof(named_argument) +
+            (name_slots.capacity() + tag_slots.capacity()) * sizeof(std::uint32_t) + tag_entries.capacity() * sizeof(tag_entry) +
+            inline_tags.heap_bytes() + sizeof(bool);
+        usage.arguments.reserve(arguments.size() + positional_arguments.size());
+        for (const auto* args : { &arguments, &positional_arguments })
+        {
+            for (const auto& arg : *args)
+            {
+                auto& a = usage.arguments.emplace_back();
+                arg->measure(a);
+                usage.metadata += a.metadata;
+                usage.callables += a.callables;
+                usage.values += a.values;
+                usage.bound += a.bound;
+            }
+        }
+        return usage;
     }
 
-    template <typename T>
-    inline const std::string& argument<T>::get_description() const
+    PX_API std::size_t memory_bytes::total() const
     {
-        return description;
+        return inline_bytes + heap_bytes;
     }
 
-    template <typename T>
-    positional_argument<T>::positional_argument(std::string_view n) :
-	positional_argument<T>::base(n)
+    PX_API memory_bytes& memory_bytes::operator+=(const memory_bytes& b)
     {
+        inline_bytes += b.inline_bytes;
+        heap_bytes += b.heap_bytes;
+        return *this;
     }
-    
-    template <typename T>
-    positional_argument<T>& positional_argument<T>::bind(positional_argument<T>::value_type* t)
+
+    PX_API std::size_t memory_breakdown::argument_usage::total() const
     {
-        bound_variable = t;
-        return *this;
+        // the inline bytes of all but the bound copy are part of the object
+        return object_bytes + metadata.heap_bytes + callables.heap_bytes + values.heap_bytes + bound.total();
     }
 
-    template <typename T>
-    void positional_argument<T>::print_help(std::ostream& o) const
+    PX_API std::size_t memory_breakdown::total() const
     {
-        o << "   "
-	  << base::get_name() << " "
-	  << base::get_description()
-	  << "\n";
+        auto bytes = schema.total();
+        for (const auto& a : arguments)
+        {
+            bytes += a.total();
+        }
+        return bytes;
     }
 
-    template <typename T>
-    positional_argument<T>& positional_argument<T>::set_validator(validation_function f)
+    PX_API argv_array::argv_array(const detail::argv_builder& b, std::string file) :
+        count(b.count()),
+        response_file(std::move(file))
     {
-        validator = std::move(f);
+        // the strings follow the pointers to them
+        const auto& bytes = b.get_bytes();
+        const auto pointers = count + 1;
+        arena = std::make_unique<char*[]>(pointers + (bytes.size() + sizeof(char*) - 1) / sizeof(char*));
+        auto* text = reinterpret_cast<char*>(arena.get() + pointers);
+        std::memcpy(text, bytes.data(), bytes.size());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            arena[i] = text + (b[i].data() - bytes.data());
+        }
+        arena[count] = nullptr;
     }
 
-    template <typename T>
-    bool positional_argument<T>::is_valid() const
+    PX_API argv_array::argv_array(argv_array&& other) noexcept :
+        arena(std::move(other.arena)),
+        count(std::exchange(other.count, 0)),
+        response_file(std::exchange(other.response_file, {}))
     {
-        return value.has_value() && validator(*value);
     }
 
-    template <typename T>
-    const typename positional_argument<T>::value_type& positional_argument<T>::get_value() const
+    PX_API argv_array& argv_array::operator=(argv_array&& other) noexcept
     {
-        if (value.has_value())
-        {
-            return *value;
-        }
-        else
+        if (this != &other)
         {
-            throw std::runtime_error("getting value from invalid argument '" + base::get_name() + "'");
+            if (!response_file.empty())
+            {
+                std::remove(response_file.c_str());
+            }
+            arena = std::move(other.arena);
+            count = std::exchange(other.count, 0);
+            response_file = std::exchange(other.response_file, {});
         }
+        return *this;
     }
 
-    template <typename T>
-    argv_iterator
-        positional_argument<T>::parse(const argv_iterator& begin,
-            const argv_iterator& end)
+    PX_API argv_array::~argv_array()
     {
-        value = detail::parse_scalar<value_type>(*begin);
-        if (bound_variable != nullptr)
+        if (!response_file.empty())
         {
-            *bound_variable = *value;
+            std::remove(response_file.c_str());
         }
-        return begin;
     }
 
-    template <typename T, typename storage>
-    bool tag_argument<T, storage>::matches(std::string_view s) const
+    PX_API char* const* argv_array::get() const
     {
-        return (!tag.empty() && tag == s) || (!alternate_tag.empty() && alternate_tag == s);
+        return arena.get();
     }
 
-    template <typename T, typename storage>
-    const std::string& tag_argument<T, storage>::get_tag() const
+    PX_API std::size_t argv_array::size() const
     {
-        return tag;
+        return count;
     }
 
-    template <typename T, typename storage>
-    const std::string& tag_argument<T, storage>::get_alternate_tag() const
+    PX_API std::string_view argv_array::operator[](std::size_t i) const
     {
-        return alternate_tag;
+        return arena[i];
     }
 
-    template <typename T, typename storage>
-    tag_argument<T, storage>& tag_argument<T, storage>::set_alternate_tag(std::string_view t)
+    PX_API const std::string& argv_array::get_response_file() const
     {
-        alternate_tag = t;
-        return *this;
+        return response_file;
     }
 
-    template <typename T, typename storage>
-    tag_argument<T, storage>::tag_argument(std::string_view n, std::string_view t) :
-        argument<tag_argument<T, storage>>(n),
-        tag(t)
+    PX_API std::size_t argv_array::max_bytes()
     {
+#if defined(_SC_ARG_MAX)
+        // room for what the kernel counts beyond the strings and pointers
+        constexpr std::size_t headroom = 4096;
+        const auto limit = ::sysconf(_SC_ARG_MAX);
+        std::size_t environment = 0;
+#ifdef __linux__
+        for (auto** e = environ; e != nullptr && *e != nullptr; ++e)
+        {
+            environment += std::strlen(*e) + 1 + sizeof(char*);
+        }
+#endif
+        if (limit > 0 && static_cast<std::size_t>(limit) > environment + headroom)
+        {
+            return static_cast<std::size_t>(limit) - environment - headroom;
+        }
+        return 0;
+#else
+        // the length of a command line on Windows
+        return 32767;
+#endif
     }
 
-    template <typename T, typename storage>
-    tag_argument<T, storage>& tag_argument<T, storage>::bind(value_type* t)
+    PX_API void command_line::set_limits(const parse_limits& l)
     {
-        bound_variable = t;
-        return *this;
+        limits = l;
     }
 
-    template <typename T, typename storage>
-    template <typename U, typename>
-    bool tag_argument<T, storage>::is_required() const
+    PX_API void command_line::set_response_files(bool r)
     {
-        return required;
+        response_files = r;
     }
 
-    template <typename T, typename storage>
-    template <typename U, typename>
-    tag_argument<T, storage>& tag_argument<T, storage>::set_required(bool r)
+    PX_API void command_line::set_dispatch(dispatch_strategy d)
     {
-        required = r;
-        return *this;
+        dispatch = d;
+        prepared = dispatch_strategy::automatic;
     }
 
-    template <typename T, typename storage>
-    template <typename U, typename>
-    tag_argument<T, storage>& tag_argument<T, storage>::set_validator(validation_function f)
+    PX_API dispatch_strategy command_line::get_dispatch() const
     {
-        validator = std::move(f);
-        return *this;
+        return (prepared != dispatch_strategy::automatic) ? prepared : dispatch;
     }
 
-    template <typename T, typename storage>
-    const typename tag_argument<T, storage>::value_type& tag_argument<T, storage>::get_value() const
+    PX_API void command_line::prepare_dispatch()
     {
-        if (!is_valid())
+        if (!tags_changed)
         {
-            throw std::runtime_error("getting value from invalid argument '" + base::get_name() + "'");
+            // moved from
+            tags_changed = std::make_unique<bool>(false);
         }
-        return value.get_value();
-    }
-
-    template <typename T, typename storage>
-    void tag_argument<T, storage>::print_help(std::ostream& o) const
-    {
-        constexpr auto alternate_tag_size = 15;
-        o << "   "
-            << tag
-            << ((!alternate_tag.empty()) ?
-                ", " + detail::pad_right(alternate_tag, alternate_tag_size - 2) :
-                detail::pad_right("", alternate_tag_size))
-            << ((required) ? "(required) " : "")
-            << base::get_description()
-            << "\n";
-    }
-
-    template <typename T, typename storage>
-    bool tag_argument<T, storage>::is_valid() const
-    {
-        if (value.has_value())
+        tag_entries.clear();
+        tag_slots.assign(std::max<std::size_t>(16, std::bit_ceil(arguments.size() * 4)), 0);
+        const auto mask = tag_slots.size() - 1;
+        repeated_tags = false;
+        std::vector<std::size_t> lengths;
+        for (std::uint32_t position = 0; position < arguments.size(); ++position)
         {
-            return validator(value.get_value());
+            static_cast<tag_argument_core&>(*arguments[position]).tags_changed = tags_changed.get();
+            for (const auto alternate : { 0u, 1u })
+            {
+                const auto slot = ((position + 1) << 1) | alternate;
+                const auto tag = get_tag(slot);
+                if (tag.empty())
+                {
+                    continue;
+                }
+                tag_entries.push_back({ static_cast<std::uint32_t>(tag.size()), slot });
+                lengths.resize(std::max(lengths.size(), tag.size() + 1));
+                ++lengths[tag.size()];
+
+                auto i = detail::hash_name(tag) & mask;
+                for (; tag_slots[i] != 0; i = (i + 1) & mask)
+                {
+                    repeated_tags = repeated_tags || get_tag(tag_slots[i]) == tag;
+                }
+                tag_slots[i] = slot;
+            }
         }
-        else return !required;
-    }
 
-    template <typename T, typename storage>
-    argv_iterator
-        tag_argument<T, storage>::parse(const argv_iterator& begin,
-            const argv_iterator& end)
-    {
-        if (std::distance(begin, end) >= 1 && matches(*begin))
+        prepared = dispatch;
+        if (prepared == dispatch_strategy::automatic)
         {
-            auto i = begin;
-            if constexpr (!std::is_same_v<T, bool>) // i.e. flag arg
+            // a token is compared with the tags of its own length only, so
+            // what the linear scan costs depends on how many share the most
+            // common length; hashing costs more the longer the token, where
+            // comparing inline keys costs the same
+            const auto same_length = lengths.empty() ? 0 : *std::max_element(lengths.begin(), lengths.end());
+            std::size_t bytes = 0;
+            for (std::size_t length = 0; length < lengths.size(); ++length)
             {
-                ++i;
+                bytes += length * lengths[length];
             }
-            i = value.parse(i, end);
-            if (bound_variable != nullptr)
+            if (tag_entries.size() <= detail::linear_dispatch_tags && same_length <= detail::linear_dispatch_same_length)
             {
-                *bound_variable = value.get_value();
+                prepared = dispatch_strategy::linear;
+            }
+            else if (tag_entries.size() <= detail::inline_dispatch_tags && lengths.size() <= detail::tag_keys::key_size &&
+                bytes >= detail::inline_dispatch_mean_length * tag_entries.size())
+            {
+                prepared = dispatch_strategy::inline_keys;
+            }
+            else
+            {
+                prepared = dispatch_strategy::hashed;
             }
-            return i;
         }
-        else
+        if (prepared != dispatch_strategy::hashed)
         {
-            return begin;
+            tag_slots.clear();
+        }
+        inline_tags.clear();
+        if (prepared == dispatch_strategy::inline_keys)
+        {
+            for (const auto& entry : tag_entries)
+            {
+                inline_tags.add(get_tag(entry.slot), entry.slot);
+            }
         }
+        prepared_arguments = arguments.size();
+        *tags_changed = false;
     }
 
-    command_line::command_line(std::string_view program_name) :
-        name(program_name)
+    PX_API std::string_view command_line::get_tag(std::uint32_t slot) const
     {
+        // arguments holds tag arguments only
+        const auto& arg = static_cast<const tag_argument_core&>(*arguments[(slot >> 1) - 1]);
+        return (slot & 1) ? arg.get_alternate_tag() : arg.get_tag();
     }
 
-    template <typename T>
-    inline positional_argument<T>& command_line::add_positional_argument(std::string_view name)
+    PX_API iargument* command_line::find_tag(std::string_view token) const
     {
-        auto arg = std::make_unique<positional_argument<T>>(name);
-	auto& ref = *arg;
-        positional_arguments.push_back(std::move(arg));
-	return ref;
+        if (prepared == dispatch_strategy::linear)
+        {
+            for (const auto& entry : tag_entries)
+            {
+                if (entry.length == token.size() && get_tag(entry.slot) == token)
+                {
+                    return arguments[(entry.slot >> 1) - 1].get();
+                }
+            }
+            return nullptr;
+        }
+        if (prepared == dispatch_strategy::inline_keys)
+        {
+            const auto slot = inline_tags.find(token);
+            return (slot != 0) ? arguments[(slot >> 1) - 1].get() : nullptr;
+        }
+
+        const auto mask = tag_slots.size() - 1;
+        for (auto i = detail::hash_name(token) & mask; tag_slots[i] != 0; i = (i + 1) & mask)
+        {
+            if (get_tag(tag_slots[i]) == token)
+            {
+                return arguments[(tag_slots[i] >> 1) - 1].get();
+            }
+        }
+        return nullptr;
     }
 
-    inline tag_argument<bool, scalar<bool>>& command_line::add_flag_argument(std::string_view name, std::string_view tag)
+    PX_API void command_line::print_help(help_sink& o)
     {
-        prevent_tag_args_after_positional_args();
-        auto arg = std::make_unique<tag_argument<bool, scalar<bool>>>(name, tag);
-	auto& ref = *arg;
-        arguments.push_back(std::move(arg));
-	return ref;
+        o.write(detail::concat({ name, (!description.empty()) ? " - " : "", description, "\n" }));
+	std::for_each(std::begin(arguments), std::end(arguments),
+		      [&o](const auto& arg) { arg->print_help(o); });
+        o.write("\n");
     }
 
-    template <typename T>
-    tag_argument<T>& command_line::add_value_argument(std::string_view name, std::string_view tag)
+#ifndef PX_NO_IOSTREAM
+    PX_API void command_line::print_help(std::ostream& o)
     {
-        prevent_tag_args_after_positional_args();
-        auto arg = std::make_unique<tag_argument<T>>(name, tag);
-	auto& ref = *arg;
-        arguments.push_back(std::move(arg));
-	return ref;
+        ostream_sink sink(o);
+        print_help(sink);
     }
+#endif
 
-    template <typename T>
-    tag_argument<T, multi_scalar<T>>& command_line::add_multi_value_argument(std::string_view name, std::string_view tag)
+    PX_API void command_line::prevent_tag_args_after_positional_args()
     {
-        prevent_tag_args_after_positional_args();
-        auto arg = std::make_unique<tag_argument<T, multi_scalar<T>>>(name, tag);
-	auto& ref = *arg;
-        arguments.push_back(std::move(arg));
-	return ref;
+        if (!positional_arguments.empty())
+        {
+            throw std::logic_error("tag arguments cannot be given after positional arguments");
+        }
     }
 
-
-#ifdef PX_HAS_SPAN
-    inline void command_line::parse(std::span<const std::string> args)
-    {
-        const auto end = args.end();
-        auto argv = args.begin();
-#else
-    inline void command_line::parse(const std::vector<std::string>& args)
+    PX_API void command_line::index_name(const iargument& arg, detail::type_id type)
     {
-        const auto end = args.cend();
-        auto argv = args.cbegin();
-#endif
-
-	const auto parse_all = [](auto& args, auto& argv, const auto& end)
-	{
-	    std::for_each(args.begin(), args.end(), 
-			  [&argv, &end](auto& arg) { argv = arg->parse(argv, end); });
-	    return argv;
-	};
-	
-        if (std::distance(argv, end) > 0)
+        const auto n = name_key(arg.get_name());
+        if (named.size() * 2 >= name_slots.size())
         {
-	    auto separator_found = false;
-	    ++argv;
-            for (; argv != end && !separator_found; ++argv)
+            // grow and reinsert; the slots hold positions in named
+            name_slots.assign(std::max<std::size_t>(16, name_slots.size() * 2), 0);
+            const auto mask = name_slots.size() - 1;
+            for (std::uint32_t position = 0; position < named.size(); ++position)
             {
-		separator_found = detail::is_separator_tag(*argv);
-                if (!separator_found)
+                auto i = named[position].hash & mask;
+                while (name_slots[i] != 0)
                 {
-		    argv = parse_all(arguments, argv, end);
-		}
+                    i = (i + 1) & mask;
+                }
+                name_slots[i] = position + 1;
             }
+        }
 
-            if (!positional_arguments.empty())
+        const auto mask = name_slots.size() - 1;
+        auto i = n.get_hash() & mask;
+        for (; name_slots[i] != 0; i = (i + 1) & mask)
+        {
+            const auto& other = named[name_slots[i] - 1];
+            if (other.hash == n.get_hash() && other.argument->get_name() == n.get_name())
             {
-		for (argv = (!separator_found) ? std::next(args.begin()) : argv;
-		     argv != end; ++argv)
-		{
-		    argv = parse_all(positional_arguments, argv, end);
-		}
+                // the first argument registered with a name keeps it
+                return;
             }
         }
-
-        detail::throw_on_invalid(arguments.cbegin(), arguments.cend());
-        detail::throw_on_invalid(positional_arguments.cbegin(), positional_arguments.cend());
-    }
-
-    inline void command_line::parse(int argc, char** argv)
-    {
-        parse(std::vector<std::string>(argv, argv + argc));
-    }
-
-    inline void command_line::print_help(std::ostream& o)
-    {
-        o << name
-            << ((!description.empty()) ? " - " + description : "")
-            << "\n";
-	std::for_each(std::begin(arguments), std::end(arguments),
-		      [&o](const auto& arg) { arg->print_help(o); });
-        o << "\n";
+        named.push_back({ &arg, type, n.get_hash() });
+        name_slots[i] = static_cast<std::uint32_t>(named.size());
     }
 
-    inline void command_line::prevent_tag_args_after_positional_args()
+    PX_API const command_line::named_argument& command_line::find_name(name_key key) const
     {
-        if (!positional_arguments.empty())
+        if (!name_slots.empty())
         {
-            throw std::logic_error("tag arguments cannot be given after positional arguments");
+            const auto mask = name_slots.size() - 1;
+            for (auto i = key.get_hash() & mask; name_slots[i] != 0; i = (i + 1) & mask)
+            {
+                const auto& n = named[name_slots[i] - 1];
+                if (n.hash == key.get_hash() && n.argument->get_name() == key.get_name())
+                {
+                    return n;
+                }
+            }
         }
+        throw std::logic_error(detail::concat({ "no argument named '", key.get_name(), "'" }));
     }
+#endif
 }
@@ -0,0 +1,801 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// declarations of the px classes only; include px.h for the definitions or
+// link against px_static, which provides explicit instantiations for the
+// types listed in PX_COMMON_TYPES
+//
+// with PX_NO_IOSTREAM defined, px does not include or use any of the stream
+// headers: values are converted with from_chars and help is written to a
+// help_sink only
+//
+// with PX_STATIC_METADATA defined, names, tags and descriptions are not
+// copied; they must have static storage duration, as string literals do
+//
+// with PX_TRACE defined, a command_line given a parse_tracer records the
+// phases of parsing and the conversion, binding and validation of each
+// argument; without it, the tracing points compile to nothing
+
+#pragma once
+
+#ifdef PX_TRACE
+#include <chrono>
+#endif
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#ifndef PX_NO_IOSTREAM
+#include <iosfwd>
+#endif
+#include <limits>
+#include <memory>
+#include <optional>
+#if __has_include(<span>)
+#include <span>
+#define PX_HAS_SPAN
+#endif
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// non-template functions are inline when px is used header-only, and are
+// compiled once into px_static otherwise
+#if defined(PX_STATIC) && defined(PX_STATIC_IMPLEMENTATION)
+#define PX_API
+#else
+#define PX_API inline
+#endif
+
+// the value types for which px_static provides explicit instantiations
+#define PX_COMMON_TYPES(X) \
+    X(int)                 \
+    X(long)                \
+    X(double)              \
+    X(std::string)         \
+    X(std::filesystem::path)
+
+namespace detail
+{
+    using type_id = const void*;
+
+    // FNV-1a; constexpr, so that names known at compile time are hashed
+    // by the compiler
+    constexpr std::uint32_t hash_name(std::string_view s)
+    {
+        std::uint32_t h = 2166136261u;
+        for (const auto c : s)
+        {
+            h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return h;
+    }
+
+    // a validator that says what it accepts, for the help
+    template <typename F>
+    concept self_describing = requires(const F& f) { std::string(f.describe()); };
+
+    class argv_builder;
+    class trace_span;
+
+    // tags of up to 31 bytes as 32 byte keys, zero padded with the length
+    // last, in one block; a byte derived from the length and the first and
+    // last bytes of each tag is compared first, 16 keys at a time where
+    // SSE2 is available, and the key only where it matches. longer tags are
+    // compared one by one
+    class tag_keys
+    {
+    public:
+        static constexpr std::size_t key_size = 32;
+
+        void clear();
+        void add(std::string_view tag, std::uint32_t slot);
+        // the slot of the first tag added that equals token, or 0
+        std::uint32_t find(std::string_view token) const;
+        std::size_t heap_bytes() const;
+
+    private:
+        struct alignas(key_size) key
+        {
+            unsigned char bytes[key_size];
+        };
+
+        static std::uint8_t fingerprint(std::string_view);
+
+        // a multiple of 16 long, so that blocks can be loaded whole
+        std::vector<std::uint8_t> fingerprints;
+        std::vector<key> keys;
+        std::vector<std::uint32_t> slots;
+        std::vector<std::pair<std::string, std::uint32_t>> longer;
+    };
+}
+
+namespace px
+{
+    // the name of an argument with its hash; declare it constexpr, or use
+    // the _px literal, to hash the name at compile time
+    class name_key
+    {
+    public:
+        constexpr explicit name_key(std::string_view n) :
+            name(n),
+            hash(detail::hash_name(n))
+        {
+        }
+
+        constexpr std::string_view get_name() const { return name; }
+        constexpr std::uint32_t get_hash() const { return hash; }
+
+    private:
+        std::string_view name;
+        std::uint32_t hash;
+    };
+
+    namespace literals
+    {
+        consteval name_key operator""_px(const char* s, std::size_t n)
+        {
+            return name_key(std::string_view(s, n));
+        }
+    }
+
+    // how parsing finds the argument a tag belongs to: by comparing it with
+    // each tag in turn, with the tags as inline keys compared a block at a
+    // time, or through a hash table of the tags; automatic chooses by the
+    // number of tags, how many share a length and how many are long
+    enum class dispatch_strategy { automatic, linear, hashed, inline_keys };
+
+    // bounds on the arguments of one parse, for input that is not trusted;
+    // they are checked on the raw tokens, before any value is converted
+    struct parse_limits
+    {
+        static constexpr auto unlimited = std::numeric_limits<std::size_t>::max();
+
+        // not counting the program name
+        std::size_t max_tokens = unlimited;
+        std::size_t max_bytes = unlimited;
+        std::size_t max_value_length = unlimited;
+        // the values following one tag, up to the next tag or separator
+        std::size_t max_values_per_argument = unlimited;
+        // response files naming response files
+        std::size_t max_include_depth = unlimited;
+
+        bool operator==(const parse_limits&) const = default;
+    };
+
+    class limit_exceeded : public std::runtime_error
+    {
+    public:
+        enum class limit { tokens, bytes, value_length, values_per_argument, include_depth };
+
+        limit_exceeded(limit, std::size_t maximum);
+        limit which() const;
+
+    private:
+        limit exceeded;
+    };
+
+    template <typename T>
+    class scalar
+    {
+    public:
+        using value_type = T;
+        bool has_value() const;
+        const value_type& get_value() const;
+        template <typename iterator>
+        iterator parse(const iterator& begin, const iterator& end);
+        void assign(value_type);
+
+    private:
+        std::optional<value_type> value = std::nullopt;
+    };
+
+    // a file mapped into memory, or read where it cannot be mapped
+    class mapped_file
+    {
+    public:
+        // throws limit_exceeded for a file larger than max_bytes
+        explicit mapped_file(const std::string& path, std::size_t max_bytes = parse_limits::unlimited);
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        ~mapped_file();
+
+        std::string_view get_text() const;
+
+    private:
+        std::string_view text;
+        std::string contents;
+        void* mapping = nullptr;
+    };
+
+    // a view of the argument, or with set_value_from_file, of the mapped
+    // contents of the file named by an argument @path
+    template <>
+    class scalar<std::string_view>
+    {
+    public:
+        using value_type = std::string_view;
+        bool has_value() const;
+        const value_type& get_value() const;
+        template <typename iterator>
+        iterator parse(const iterator& begin, const iterator& end);
+        void assign(value_type);
+
+        void set_value_from_file(bool);
+
+    private:
+        std::optional<value_type> value = std::nullopt;
+        bool from_file = false;
+        std::unique_ptr<mapped_file> file;
+    };
+
+    template <>
+    class scalar<bool>
+    {
+    public:
+        using value_type = bool;
+        bool has_value() const;
+        const value_type& get_value() const;
+        template <typename iterator>
+        iterator parse(const iterator& begin, const iterator& end);
+    private:
+        bool value = false;
+    };
+
+    template <typename T>
+    class multi_scalar
+    {
+    public:
+        using value_type = std::vector<T>;
+        // appends the values an argument stands for, such as the paths
+        // matching a pattern, instead of converting it to one value
+        using expander = std::function<void(std::string_view, value_type&)>;
+
+        bool has_value() const;
+        const value_type& get_value() const;
+
+        template <typename iterator>
+        iterator parse(const iterator& begin, const iterator& end);
+        void assign(value_type);
+
+        void set_expander(expander);
+
+    private:
+        value_type value;
+        expander expand;
+    };
+
+#ifdef PX_STATIC_METADATA
+    using metadata_string = std::string_view;
+#else
+    using metadata_string = std::string;
+#endif
+
+#ifdef PX_HAS_SPAN
+    using argv_iterator = std::span<const std::string>::iterator;
+#else
+    using argv_iterator = std::vector<std::string>::const_iterator;
+#endif
+    // arguments for a child process, the pointers and the strings in one
+    // allocation; when they did not fit in the space the system allows,
+    // they are in a response file and the child is given @path instead,
+    // which a command_line expands with set_response_files, as does
+    // response_files::expand in px_response.h. the file is removed with the
+    // array, so the array must outlive the child, or at least its parse:
+    // wait for the child before dropping it
+    class argv_array
+    {
+    public:
+        argv_array(const argv_array&) = delete;
+        argv_array& operator=(const argv_array&) = delete;
+        argv_array(argv_array&&) noexcept;
+        argv_array& operator=(argv_array&&) noexcept;
+        ~argv_array();
+
+        // terminated by a null pointer, for posix_spawn and exec
+        char* const* get() const;
+        std::size_t size() const;
+        std::string_view operator[](std::size_t) const;
+        // empty unless the arguments were written to a response file
+        const std::string& get_response_file() const;
+
+        // the bytes of arguments and their pointers that fit next to the
+        // environment of this process
+        static std::size_t max_bytes();
+
+    private:
+        friend class command_line;
+        argv_array(const detail::argv_builder&, std::string response_file = {});
+
+        std::unique_ptr<char*[]> arena;
+        std::size_t count = 0;
+        std::string response_file;
+    };
+
+    // the destination of help text
+    class help_sink
+    {
+    public:
+        virtual ~help_sink() = default;
+        virtual void write(std::string_view) = 0;
+    };
+
+    class string_sink : public help_sink
+    {
+    public:
+        explicit string_sink(std::string&);
+        void write(std::string_view) override;
+
+    private:
+        std::string& s;
+    };
+
+    class file_sink : public help_sink
+    {
+    public:
+        explicit file_sink(std::FILE*);
+        void write(std::string_view) override;
+
+    private:
+        std::FILE* file;
+    };
+
+#if __has_include(<unistd.h>)
+    class fd_sink : public help_sink
+    {
+    public:
+        explicit fd_sink(int);
+        void write(std::string_view) override;
+
+    private:
+        int fd;
+    };
+#endif
+
+#ifndef PX_NO_IOSTREAM
+    class ostream_sink : public help_sink
+    {
+    public:
+        explicit ostream_sink(std::ostream&);
+        void write(std::string_view) override;
+
+    private:
+        std::ostream& o;
+    };
+#endif
+
+#ifdef PX_TRACE
+    // timed spans of parsing, kept in a ring buffer allocated up front, so
+    // that recording costs the same throughout; when full, the oldest are
+    // overwritten. names refer to the arguments, and must be written while
+    // they live
+    class parse_tracer
+    {
+    public:
+        explicit parse_tracer(std::size_t capacity = 4096);
+
+        std::size_t size() const;
+        // the spans lost to overwriting
+        std::size_t get_dropped() const;
+        void clear();
+
+        // as Chrome trace event JSON, as chrome://tracing and Perfetto read
+        void write(help_sink&) const;
+
+    private:
+        friend class detail::trace_span;
+
+        struct span
+        {
+            std::string_view name;
+            const char* category;
+            std::int64_t begin;
+            std::int64_t duration;
+        };
+
+        void record(std::string_view name, const char* category, std::int64_t begin, std::int64_t end);
+
+        std::vector<span> spans;
+        std::size_t next = 0;
+        std::size_t recorded = 0;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+#endif
+
+    // bytes an object takes itself, and bytes it allocates
+    struct memory_bytes
+    {
+        std::size_t inline_bytes = 0;
+        std::size_t heap_bytes = 0;
+
+        std::size_t total() const;
+        memory_bytes& operator+=(const memory_bytes&);
+    };
+
+    // the memory a command line holds, by category and by argument; heap
+    // bytes are those of strings, paths and vectors, by capacity. what the
+    // targets of std::function members allocate cannot be known, nor what
+    // values of other types allocate, and these are not counted
+    struct memory_breakdown
+    {
+        struct argument_usage
+        {
+            std::string_view name;
+            // the argument object, which holds the inline bytes of metadata,
+            // callables and values
+            std::size_t object_bytes = 0;
+            // name, tags, description and validator help
+            memory_bytes metadata;
+            // validator, default and expander
+            memory_bytes callables;
+            // the value parsed
+            memory_bytes values;
+            // the copy in the bound variable, which the caller owns
+            memory_bytes bound;
+
+            std::size_t total() const;
+        };
+
+        // the command line, its containers and its copy of argv
+        memory_bytes schema;
+        // the sums over the arguments
+        memory_bytes metadata;
+        memory_bytes callables;
+        memory_bytes values;
+        memory_bytes bound;
+        std::vector<argument_usage> arguments;
+
+        std::size_t total() const;
+    };
+
+    class iargument
+    {
+    public:
+        virtual ~iargument() = default;
+        virtual void print_help(help_sink&) const = 0;
+        virtual argv_iterator parse(const argv_iterator&, const argv_iterator&) = 0;
+        virtual bool is_valid() const = 0;
+        // gives an argument that was not parsed its default, if it has one
+        virtual void apply_default() = 0;
+        // appends the arguments that give its value, if it has one
+        virtual void serialize(detail::argv_builder&) const = 0;
+        virtual void measure(memory_breakdown::argument_usage&) const = 0;
+
+        virtual const metadata_string& get_name() const = 0;
+        virtual const metadata_string& get_description() const = 0;
+    };
+
+    // the part of every argument that does not depend on its value type
+    class argument_core : public iargument
+    {
+    public:
+        argument_core(std::string_view n);
+
+        const metadata_string& get_name() const override;
+        const metadata_string& get_description() const override;
+        // what the validator accepts, if it says
+        const std::string& get_validator_help() const;
+
+    protected:
+        void store_description(std::string_view d);
+        void store_validator_help(std::string);
+        void measure_metadata(memory_breakdown::argument_usage&) const;
+
+    private:
+        metadata_string name;
+        metadata_string description;
+        std::string validator_help;
+    };
+
+    template <typename Derived, typename core = argument_core>
+    class argument : public core
+    {
+    public:
+        using core::core;
+        virtual ~argument() = default;
+
+        Derived& set_description(std::string_view d);
+
+    private:
+        Derived* this_as_derived() { return static_cast<Derived*>(this); }
+    };
+
+    // help and validation of a positional argument; the typed front-end only
+    // converts and stores the value
+    class positional_argument_core : public argument_core
+    {
+    public:
+        using argument_core::argument_core;
+
+        void print_help(help_sink&) const override;
+        bool is_valid() const override;
+        void apply_default() override;
+
+    protected:
+        virtual bool has_value() const = 0;
+        virtual bool validate() const = 0;
+    };
+
+    template <typename T>
+    class positional_argument : public argument<positional_argument<T>, positional_argument_core>
+    {
+    public:
+        using value_type = T;
+        using validation_function = std::function<bool(const value_type&)>;
+        using base = argument<positional_argument<T>, positional_argument_core>;
+
+        positional_argument(std::string_view n);
+        virtual ~positional_argument() = default;
+
+        argv_iterator parse(const argv_iterator&, const argv_iterator&) override;
+        void serialize(detail::argv_builder&) const override;
+        void measure(memory_breakdown::argument_usage&) const override;
+
+        const value_type& get_value() const;
+        positional_argument<T>& bind(T*);
+
+        positional_argument<T>& set_validator(validation_function);
+        template <detail::self_describing F>
+        positional_argument<T>& set_validator(F);
+
+    private:
+        bool has_value() const override;
+        bool validate() const override;
+
+        std::optional<value_type> value = std::nullopt;
+        value_type* bound_variable = nullptr;
+        validation_function validator = [](const auto&) { return true; };
+    };
+
+    // matching, help, required handling and validation of a tag argument; the
+    // typed front-end only converts, stores and binds the value
+    class tag_argument_core : public argument_core
+    {
+    public:
+        tag_argument_core(std::string_view n, std::string_view t, bool is_flag);
+
+        bool is_valid() const override;
+        void print_help(help_sink&) const override;
+        argv_iterator parse(const argv_iterator&, const argv_iterator&) override;
+
+        bool is_required() const;
+        const metadata_string& get_tag() const;
+        const metadata_string& get_alternate_tag() const;
+
+    protected:
+        void store_required(bool);
+        void store_alternate_tag(std::string_view);
+        void measure_metadata(memory_breakdown::argument_usage&) const;
+
+        virtual bool has_value() const = 0;
+        virtual bool validate() const = 0;
+        virtual argv_iterator convert(const argv_iterator&, const argv_iterator&) = 0;
+        // the default as shown in the help, computed when it is shown
+        virtual std::string describe_default() const = 0;
+
+    private:
+        friend class command_line;
+
+        bool matches(std::string_view) const;
+        metadata_string tag;
+        metadata_string alternate_tag;
+        // set when the tags change, so that the command line indexing them
+        // prepares its dispatch again
+        bool* tags_changed = nullptr;
+        bool flag;
+        bool required = false;
+    };
+
+    template <typename T, typename storage = scalar<T>>
+    class tag_argument : public argument<tag_argument<T, storage>, tag_argument_core>
+    {
+    public:
+        using value_type = typename storage::value_type;
+        using validation_function = std::function<bool(const value_type&)>;
+        using base = argument<tag_argument<T, storage>, tag_argument_core>;
+
+        tag_argument(std::string_view n, std::string_view t);
+        virtual ~tag_argument() = default;
+
+        const value_type& get_value() const;
+        tag_argument<T, storage>& bind(value_type*);
+
+        bool is_required() const requires (!std::is_same_v<T, bool>);
+        tag_argument<T, storage>& set_required(bool) requires (!std::is_same_v<T, bool>);
+
+        tag_argument<T, storage>& set_validator(validation_function f) requires (!std::is_same_v<T, bool>);
+        template <detail::self_describing F>
+        tag_argument<T, storage>& set_validator(F f) requires (!std::is_same_v<T, bool>);
+
+        tag_argument<T, storage>& set_alternate_tag(std::string_view);
+
+        // the factory runs after parsing, and only if the argument was not
+        // given; its value is bound and validated as a parsed one
+        tag_argument<T, storage>& set_default(std::function<value_type()>) requires (!std::is_same_v<T, bool>);
+        void apply_default() override;
+        void serialize(detail::argv_builder&) const override;
+        void measure(memory_breakdown::argument_usage&) const override;
+
+        // a value @path is the contents of the file at path, mapped for as
+        // long as the argument lives
+        tag_argument<T, storage>& set_value_from_file(bool) requires std::is_same_v<storage, scalar<std::string_view>>;
+        tag_argument<T, storage>& set_expander(typename multi_scalar<T>::expander)
+            requires std::is_same_v<storage, multi_scalar<T>>;
+
+    private:
+        bool has_value() const override;
+        bool validate() const override;
+        argv_iterator convert(const argv_iterator&, const argv_iterator&) override;
+        std::string describe_default() const override;
+
+        storage value;
+        value_type* bound_variable = nullptr;
+        validation_function validator = [](const auto&) { return true; };
+        std::function<value_type()> default_value;
+    };
+
+    class command_line
+    {
+    public:
+        command_line(std::string_view program_name);
+
+        tag_argument<bool, scalar<bool>>& add_flag_argument(std::string_view, std::string_view);
+        template <typename T>
+        tag_argument<T>& add_value_argument(std::string_view, std::string_view);
+        template <typename T>
+        tag_argument<T, multi_scalar<T>>& add_multi_value_argument(std::string_view name, std::string_view);
+        template <typename T>
+        positional_argument<T>& add_positional_argument(std::string_view);
+
+        // the value of the argument registered first with the given name;
+        // T is the value type of the argument, std::vector<T> for a multi
+        // value argument and bool for a flag
+        template <typename T>
+        const T& get(std::string_view) const;
+        template <typename T>
+        const T& get(name_key) const;
+
+        void set_limits(const parse_limits&);
+        // off unless set; when on, a program name followed by nothing but
+        // @path, as to_argv gives a child when it spills, stands for the
+        // arguments in the response file at path, tokenized like a preset
+        // and kept for std::string_view values to refer into. a file that
+        // cannot be read throws, as does one larger than max_bytes, before
+        // it is read; arguments in it are not expanded again, and a
+        // max_include_depth of 0 rejects the file
+        void set_response_files(bool);
+
+        // automatic unless set; the strategy is chosen and the tags are
+        // indexed at the first parse after arguments are added
+        void set_dispatch(dispatch_strategy);
+        // the strategy of the last parse, or the one set before it
+        dispatch_strategy get_dispatch() const;
+
+        void print_help(help_sink&);
+#ifndef PX_NO_IOSTREAM
+        void print_help(std::ostream&);
+#endif
+#ifdef PX_HAS_SPAN
+        void parse(std::span<const std::string>);
+#else
+        void parse(const std::vector<std::string>&);
+#endif
+        // keeps a copy of argv, which std::string_view values refer into
+        void parse(int argc, char** argv);
+#ifdef PX_TRACE
+        // records the parses that follow, until set to nullptr
+        void set_tracer(parse_tracer*);
+#endif
+
+        // the arguments that give the values parsed, or those of the
+        // arguments whose names pass the filter, for a child process; they
+        // go to a response file when they take more than max_bytes, which
+        // lives as long as the array returned
+        argv_array to_argv(std::string_view program, const std::function<bool(std::string_view)>& filter = {},
+            std::size_t max_bytes = argv_array::max_bytes()) const;
+
+        // the bytes held by the command line and each of its arguments
+        memory_breakdown memory_usage() const;
+
+    private:
+        struct named_argument
+        {
+            const iargument* argument;
+            detail::type_id type;
+            std::uint32_t hash;
+        };
+
+        void parse_response_file(std::string_view program, const std::string& path);
+#ifdef PX_HAS_SPAN
+        void parse_arguments(std::span<const std::string>);
+#else
+        void parse_arguments(const std::vector<std::string>&);
+#endif
+        void prevent_tag_args_after_positional_args();
+        void index_name(const iargument&, detail::type_id);
+        const named_argument& find_name(name_key) const;
+        void prepare_dispatch();
+        iargument* find_tag(std::string_view) const;
+        std::string_view get_tag(std::uint32_t slot) const;
+
+        metadata_string name;
+        metadata_string description;
+        parse_limits limits;
+        bool response_files = false;
+#ifdef PX_TRACE
+        parse_tracer* tracer = nullptr;
+#endif
+        std::vector<std::string> given;
+        std::vector<std::unique_ptr<iargument>> arguments;
+        std::vector<std::unique_ptr<iargument>> positional_arguments;
+        // open addressing index by name hash into named, which holds the
+        // arguments in the order of registration
+        std::vector<named_argument> named;
+        std::vector<std::uint32_t> name_slots;
+        dispatch_strategy dispatch = dispatch_strategy::automatic;
+        // automatic until prepared for the arguments there are
+        dispatch_strategy prepared = dispatch_strategy::automatic;
+        std::size_t prepared_arguments = 0;
+        // set by the arguments when a tag is set after they were indexed; on
+        // the heap, so that it stays put when the command line is moved
+        std::unique_ptr<bool> tags_changed = std::make_unique<bool>(false);
+        // a tag given more than once is parsed by each of its arguments, by
+        // offering every token to every argument
+        bool repeated_tags = false;
+        // the tags, each as position in arguments + 1 and whether the
+        // alternate tag is meant, with its length to compare first
+        struct tag_entry
+        {
+            std::uint32_t length;
+            std::uint32_t slot;
+        };
+        std::vector<tag_entry> tag_entries;
+        // open addressing index by tag hash, holding the slots of the tags
+        std::vector<std::uint32_t> tag_slots;
+        detail::tag_keys inline_tags;
+    };
+}
+
+#ifdef PX_STATIC
+#include <filesystem>
+
+// when linking against px_static, suppress implicit instantiation of the
+// common types in every translation unit; px_static provides them
+#define PX_EXTERN_INSTANTIATION(T)                                                              \
+    extern template class px::scalar<T>;                                                        \
+    extern template class px::multi_scalar<T>;                                                  \
+    extern template class px::tag_argument<T>;                                                  \
+    extern template class px::tag_argument<T, px::multi_scalar<T>>;                             \
+    extern template class px::positional_argument<T>;                                           \
+    extern template px::tag_argument<T>&                                                        \
+        px::command_line::add_value_argument<T>(std::string_view, std::string_view);            \
+    extern template px::tag_argument<T, px::multi_scalar<T>>&                                   \
+        px::command_line::add_multi_value_argument<T>(std::string_view, std::string_view);      \
+    extern template px::positional_argument<T>&                                                 \
+        px::command_line::add_positional_argument<T>(std::string_view);                         \
+    extern template const T& px::command_line::get<T>(std::string_view) const;                  \
+    extern template const T& px::command_line::get<T>(px::name_key) const;                      \
+    extern template const std::vector<T>& px::command_line::get<std::vector<T>>(std::string_view) const; \
+    extern template const std::vector<T>& px::command_line::get<std::vector<T>>(px::name_key) const;
+
+extern template class px::tag_argument<bool, px::scalar<bool>>;
+extern template const bool& px::command_line::get<bool>(std::string_view) const;
+extern template const bool& px::command_line::get<bool>(px::name_key) const;
+PX_COMMON_TYPES(PX_EXTERN_INSTANTIATION)
+#undef PX_EXTERN_INSTANTIATION
+#endif
@@ -0,0 +1,943 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// a frozen schema: the arguments are registered once with a schema_builder
+// and frozen into a dense table of metadata, and every parse stores only the
+// values actually given in a sparse parse_result, allocated from an arena
+//
+// unlike command_line, a frozen schema has no per argument value storage,
+// bound variables or positional arguments; values are read back from the
+// parse_result with the key returned at registration
+//
+// an override_layer parses a few more arguments on top of a base
+// parse_result and stores only those; lookups fall through to the base
+
+#pragma once
+
+#include "px.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+
+namespace px
+{
+    // identifies an argument of a frozen schema and the type of its value
+    template <typename T>
+    struct schema_key
+    {
+        using value_type = T;
+        std::uint32_t index;
+    };
+
+    class frozen_schema;
+    class schema_builder;
+    class parse_result;
+    class override_layer;
+}
+
+namespace detail
+{
+    template <typename T>
+    struct is_pmr_vector : std::false_type {};
+
+    template <typename T>
+    struct is_pmr_vector<std::pmr::vector<T>> : std::true_type {};
+
+    enum class schema_kind : std::uint8_t { flag, value, multi_value };
+
+    class result_store;
+
+    // the memory of a parse_result: a buffer that parses take their values
+    // from, grown after a parse that needed more to the most any parse took,
+    // so that parses of similar arguments do not allocate once warm
+    class result_arena
+    {
+    public:
+        explicit result_arena(std::size_t bytes) :
+            buffer(std::make_unique<std::byte[]>(bytes)),
+            size(bytes),
+            resource(buffer.get(), bytes, &upstream)
+        {
+        }
+
+        std::pmr::memory_resource& memory()
+        {
+            return resource;
+        }
+
+        // the size the buffer should have to hold all that was allocated
+        // since the last release, or 0 if it did
+        std::size_t get_needed() const
+        {
+            return (upstream.allocated == 0) ? 0 : size + upstream.allocated;
+        }
+
+        // keeps the buffer
+        void release()
+        {
+            resource.release();
+        }
+
+    private:
+        // counts what the buffer did not hold
+        class counting_resource : public std::pmr::memory_resource
+        {
+        public:
+            std::size_t allocated = 0;
+
+        private:
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override
+            {
+                allocated += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+            {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+
+        std::unique_ptr<std::byte[]> buffer;
+        std::size_t size;
+        counting_resource upstream;
+        std::pmr::monotonic_buffer_resource resource;
+    };
+
+    // the metadata of one argument; the value type is only known to its
+    // store function
+    struct schema_entry
+    {
+        px::metadata_string name;
+        px::metadata_string tag;
+        px::metadata_string alternate_tag;
+        px::metadata_string description;
+        void (*store)(result_store&, std::uint32_t, std::string_view);
+        std::uint32_t validator = no_validator;
+        schema_kind kind;
+        bool required = false;
+
+        static constexpr auto no_validator = std::numeric_limits<std::uint32_t>::max();
+    };
+
+    // open addressing hash table from tag to entry index; it holds
+    // indices only, so it stays valid when the schema is moved
+    class tag_index
+    {
+    public:
+        tag_index() = default;
+        explicit tag_index(const std::vector<schema_entry>&);
+
+        std::uint32_t find(const std::vector<schema_entry>&, std::string_view) const;
+
+        static constexpr auto npos = std::numeric_limits<std::uint32_t>::max();
+
+    private:
+        void insert(const std::vector<schema_entry>&, std::string_view, std::uint32_t);
+
+        // entry index + 1 and whether the alternate tag is meant, 0 when empty
+        std::vector<std::uint32_t> slots;
+    };
+}
+
+namespace px
+{
+    // the values given on one command line, keyed by argument index; only
+    // the arguments that were given take memory
+    class parse_result
+    {
+    public:
+        parse_result() = default;
+        parse_result(parse_result&&) noexcept = default;
+        parse_result& operator=(parse_result&&) noexcept;
+        ~parse_result();
+
+        // the value of an argument; flags and multi value arguments that
+        // were not given are false and empty, other arguments throw
+        template <typename T>
+        const T& get(schema_key<T>) const;
+        template <typename T>
+        const T* find(schema_key<T>) const;
+        template <typename T>
+        bool has_value(schema_key<T>) const;
+
+        // the number of arguments given
+        std::size_t size() const;
+        // forgets all values; the memory is kept for the next parse, grown
+        // to what this one took if that was more
+        void clear();
+
+    private:
+        friend class detail::result_store;
+        friend class frozen_schema;
+
+        struct slot
+        {
+            std::uint32_t index;
+            detail::type_id type;
+            void* value;
+            void (*destroy)(void*);
+        };
+
+        // the values, leaving the arena as it is
+        void destroy_slots() noexcept;
+        const slot* find_slot(std::uint32_t) const;
+        std::pmr::memory_resource& memory();
+
+        std::unique_ptr<detail::result_arena> arena;
+        // sorted by index
+        std::vector<slot> slots;
+    };
+
+}
+
+namespace detail
+{
+    // the typed stores of the frozen schema write through this
+    class result_store
+    {
+    public:
+        explicit result_store(px::parse_result& r) : result(r) {}
+
+        template <typename T>
+        T* find(std::uint32_t index);
+        template <typename T, typename... Args>
+        T& emplace(std::uint32_t index, Args&&... args);
+
+    private:
+        px::parse_result& result;
+    };
+
+    template <typename T>
+    void store_value(result_store& r, std::uint32_t index, std::string_view s)
+    {
+        if (auto* value = r.find<T>(index); value != nullptr)
+        {
+            *value = parse_scalar<T>(s);
+        }
+        else
+        {
+            r.emplace<T>(index, parse_scalar<T>(s));
+        }
+    }
+
+    template <typename T>
+    void store_multi_value(result_store& r, std::uint32_t index, std::string_view s)
+    {
+        auto* values = r.find<std::pmr::vector<T>>(index);
+        if (values == nullptr)
+        {
+            values = &r.emplace<std::pmr::vector<T>>(index);
+        }
+        values->push_back(parse_scalar<T>(s));
+    }
+
+    inline void store_flag(result_store& r, std::uint32_t index, std::string_view)
+    {
+        if (r.find<bool>(index) == nullptr)
+        {
+            r.emplace<bool>(index, true);
+        }
+    }
+}
+
+namespace px
+{
+    // the registration handle of an argument; converts to its key
+    template <typename T>
+    class schema_argument
+    {
+    public:
+        using value_type = T;
+        using validation_function = std::function<bool(const value_type&)>;
+
+        schema_argument(schema_builder&, std::uint32_t);
+
+        schema_argument<T>& set_description(std::string_view);
+        schema_argument<T>& set_alternate_tag(std::string_view);
+        schema_argument<T>& set_required(bool) requires (!std::is_same_v<T, bool>);
+        schema_argument<T>& set_validator(validation_function) requires (!std::is_same_v<T, bool>);
+
+        schema_key<T> key() const;
+        operator schema_key<T>() const;
+
+    private:
+        detail::schema_entry& entry();
+
+        schema_builder* builder;
+        std::uint32_t index;
+    };
+
+    class schema_builder
+    {
+    public:
+        explicit schema_builder(std::string_view program_name);
+
+        schema_argument<bool> add_flag_argument(std::string_view, std::string_view);
+        template <typename T>
+        schema_argument<T> add_value_argument(std::string_view, std::string_view);
+        template <typename T>
+        schema_argument<std::pmr::vector<T>> add_multi_value_argument(std::string_view, std::string_view);
+
+        schema_builder& set_limits(const parse_limits&);
+
+        frozen_schema freeze() &&;
+
+    private:
+        template <typename>
+        friend class schema_argument;
+
+        template <typename T>
+        schema_argument<T> add(std::string_view, std::string_view, detail::schema_kind,
+            void (*)(detail::result_store&, std::uint32_t, std::string_view));
+
+        metadata_string name;
+        std::vector<detail::schema_entry> entries;
+        std::vector<std::function<bool(const void*)>> validators;
+        parse_limits limits;
+    };
+
+    class frozen_schema
+    {
+    public:
+#ifdef PX_HAS_SPAN
+        parse_result parse(std::span<const std::string>) const;
+        void parse(std::span<const std::string>, parse_result&) const;
+        // tokens that refer into a buffer, which are not copied
+        void parse(std::span<const std::string_view>, parse_result&) const;
+#else
+        parse_result parse(const std::vector<std::string>&) const;
+        void parse(const std::vector<std::string>&, parse_result&) const;
+        void parse(const std::vector<std::string_view>&, parse_result&) const;
+#endif
+        parse_result parse(int argc, char** argv) const;
+
+        void print_help(help_sink&) const;
+#ifndef PX_NO_IOSTREAM
+        void print_help(std::ostream&) const;
+#endif
+
+        std::size_t size() const;
+        const parse_limits& get_limits() const;
+
+    private:
+        friend class schema_builder;
+        friend class override_layer;
+
+        frozen_schema(metadata_string, std::vector<detail::schema_entry>,
+            std::vector<std::function<bool(const void*)>>, parse_limits);
+
+        template <typename range>
+        void store(const range&, parse_result&) const;
+        void validate_required(const parse_result&) const;
+        void validate(const parse_result&) const;
+
+        metadata_string name;
+        std::vector<detail::schema_entry> entries;
+        std::vector<std::function<bool(const void*)>> validators;
+        std::vector<std::uint32_t> required;
+        detail::tag_index tags;
+        parse_limits limits;
+    };
+
+    // the arguments of one request on top of a base parse_result; only the
+    // overridden values are stored, everything else is read from the base.
+    // the schema and the base must outlive the layer
+    class override_layer
+    {
+    public:
+        override_layer(const frozen_schema&, const parse_result& base);
+
+        // replaces the overrides with the arguments given; required
+        // arguments are satisfied by the base and a multi value argument
+        // that is given replaces the values of the base
+#ifdef PX_HAS_SPAN
+        void parse(std::span<const std::string>);
+#else
+        void parse(const std::vector<std::string>&);
+#endif
+
+        template <typename T>
+        const T& get(schema_key<T>) const;
+        template <typename T>
+        const T* find(schema_key<T>) const;
+        template <typename T>
+        bool has_value(schema_key<T>) const;
+        template <typename T>
+        bool is_overridden(schema_key<T>) const;
+
+        // the number of arguments overridden
+        std::size_t size() const;
+        // forgets the overrides and keeps the memory for the next request
+        void clear();
+
+        const parse_result& base() const;
+
+    private:
+        const frozen_schema* schema;
+        const parse_result* base_result;
+        parse_result overrides;
+    };
+}
+
+namespace detail
+{
+    inline tag_index::tag_index(const std::vector<schema_entry>& entries)
+    {
+        std::size_t capacity = 8;
+        while (capacity < entries.size() * 4)
+        {
+            capacity *= 2;
+        }
+        slots.assign(capacity, 0);
+
+        for (std::uint32_t i = 0; i < entries.size(); ++i)
+        {
+            insert(entries, entries[i].tag, i);
+            if (!entries[i].alternate_tag.empty())
+            {
+                insert(entries, entries[i].alternate_tag, i);
+            }
+        }
+    }
+
+    inline void tag_index::insert(const std::vector<schema_entry>& entries,
+        std::string_view tag, std::uint32_t index)
+    {
+        if (find(entries, tag) != npos)
+        {
+            throw std::logic_error(concat({ "tag '", tag, "' is registered more than once" }));
+        }
+
+        const auto mask = slots.size() - 1;
+        auto i = hash_name(tag) & mask;
+        while (slots[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+        const auto alternate = (tag != entries[index].tag) ? 1u : 0u;
+        slots[i] = ((index + 1) << 1) | alternate;
+    }
+
+    inline std::uint32_t tag_index::find(const std::vector<schema_entry>& entries,
+        std::string_view tag) const
+    {
+        if (slots.empty())
+        {
+            return npos;
+        }
+
+        const auto mask = slots.size() - 1;
+        for (auto i = hash_name(tag) & mask; slots[i] != 0; i = (i + 1) & mask)
+        {
+            const auto index = (slots[i] >> 1) - 1;
+            const auto& entry = entries[index];
+            if (tag == std::string_view((slots[i] & 1) ? entry.alternate_tag : entry.tag))
+            {
+                return index;
+            }
+        }
+        return npos;
+    }
+}
+
+namespace px
+{
+    inline parse_result& parse_result::operator=(parse_result&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy_slots();
+            arena = std::move(other.arena);
+            slots = std::move(other.slots);
+        }
+        return *this;
+    }
+
+    inline parse_result::~parse_result()
+    {
+        destroy_slots();
+    }
+
+    template <typename T>
+    const T* parse_result::find(schema_key<T> key) const
+    {
+        const auto* s = find_slot(key.index);
+        if (s == nullptr)
+        {
+            return nullptr;
+        }
+        else if (s->type != detail::type_id_of<T>())
+        {
+            throw std::logic_error("argument read with a key of another schema");
+        }
+        return static_cast<const T*>(s->value);
+    }
+
+    template <typename T>
+    const T& parse_result::get(schema_key<T> key) const
+    {
+        if (const auto* value = find(key); value != nullptr)
+        {
+            return *value;
+        }
+        else if constexpr (std::is_same_v<T, bool> || detail::is_pmr_vector<T>::value)
+        {
+            static const T none{};
+            return none;
+        }
+        else
+        {
+            throw std::runtime_error("getting value from argument that was not given");
+        }
+    }
+
+    template <typename T>
+    bool parse_result::has_value(schema_key<T> key) const
+    {
+        return find_slot(key.index) != nullptr;
+    }
+
+    inline std::size_t parse_result::size() const
+    {
+        return slots.size();
+    }
+
+    inline void parse_result::clear()
+    {
+        destroy_slots();
+        if (arena)
+        {
+            if (const auto needed = arena->get_needed(); needed != 0)
+            {
+                arena = std::make_unique<detail::result_arena>(needed);
+            }
+            else
+            {
+                arena->release();
+            }
+        }
+    }
+
+    inline void parse_result::destroy_slots() noexcept
+    {
+        for (auto& s : slots)
+        {
+            if (s.destroy != nullptr)
+            {
+                s.destroy(s.value);
+            }
+        }
+        slots.clear();
+    }
+
+    inline const parse_result::slot* parse_result::find_slot(std::uint32_t index) const
+    {
+        const auto s = std::lower_bound(slots.begin(), slots.end(), index,
+            [](const slot& s, std::uint32_t i) { return s.index < i; });
+        return (s != slots.end() && s->index == index) ? &*s : nullptr;
+    }
+
+    inline std::pmr::memory_resource& parse_result::memory()
+    {
+        if (!arena)
+        {
+            arena = std::make_unique<detail::result_arena>(1024);
+        }
+        return arena->memory();
+    }
+}
+
+namespace detail
+{
+    template <typename T>
+    T* result_store::find(std::uint32_t index)
+    {
+        return const_cast<T*>(static_cast<const px::parse_result&>(result).find(px::schema_key<T>{ index }));
+    }
+
+    template <typename T, typename... Args>
+    T& result_store::emplace(std::uint32_t index, Args&&... args)
+    {
+        auto& memory = result.memory();
+        T* value = nullptr;
+        if constexpr (is_pmr_vector<T>::value)
+        {
+            value = ::new (memory.allocate(sizeof(T), alignof(T))) T(&memory);
+        }
+        else
+        {
+            value = ::new (memory.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        void (*destroy)(void*) = nullptr;
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+        }
+
+        auto& slots = result.slots;
+        const auto s = std::lower_bound(slots.begin(), slots.end(), index,
+            [](const px::parse_result::slot& s, std::uint32_t i) { return s.index < i; });
+        slots.insert(s, px::parse_result::slot{ index, type_id_of<T>(), value, destroy });
+        return *value;
+    }
+}
+
+namespace px
+{
+    template <typename T>
+    schema_argument<T>::schema_argument(schema_builder& b, std::uint32_t i) :
+        builder(&b),
+        index(i)
+    {
+    }
+
+    template <typename T>
+    detail::schema_entry& schema_argument<T>::entry()
+    {
+        return builder->entries[index];
+    }
+
+    template <typename T>
+    schema_argument<T>& schema_argument<T>::set_description(std::string_view d)
+    {
+        entry().description = d;
+        return *this;
+    }
+
+    template <typename T>
+    schema_argument<T>& schema_argument<T>::set_alternate_tag(std::string_view t)
+    {
+        entry().alternate_tag = t;
+        return *this;
+    }
+
+    template <typename T>
+    schema_argument<T>& schema_argument<T>::set_required(bool r) requires (!std::is_same_v<T, bool>)
+    {
+        entry().required = r;
+        return *this;
+    }
+
+    template <typename T>
+    schema_argument<T>& schema_argument<T>::set_validator(validation_function f) requires (!std::is_same_v<T, bool>)
+    {
+        auto erased = [f = std::move(f)](const void* value) { return f(*static_cast<const T*>(value)); };
+        if (auto& e = entry(); e.validator == detail::schema_entry::no_validator)
+        {
+            e.validator = static_cast<std::uint32_t>(builder->validators.size());
+            builder->validators.push_back(std::move(erased));
+        }
+        else
+        {
+            builder->validators[e.validator] = std::move(erased);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    schema_key<T> schema_argument<T>::key() const
+    {
+        return schema_key<T>{ index };
+    }
+
+    template <typename T>
+    schema_argument<T>::operator schema_key<T>() const
+    {
+        return key();
+    }
+
+    inline schema_builder::schema_builder(std::string_view program_name) :
+        name(program_name)
+    {
+    }
+
+    template <typename T>
+    schema_argument<T> schema_builder::add(std::string_view n, std::string_view t, detail::schema_kind kind,
+        void (*store)(detail::result_store&, std::uint32_t, std::string_view))
+    {
+        const auto index = static_cast<std::uint32_t>(entries.size());
+        auto& e = entries.emplace_back();
+        e.name = n;
+        e.tag = t;
+        e.store = store;
+        e.kind = kind;
+        return schema_argument<T>(*this, index);
+    }
+
+    inline schema_argument<bool> schema_builder::add_flag_argument(std::string_view n, std::string_view t)
+    {
+        return add<bool>(n, t, detail::schema_kind::flag, &detail::store_flag);
+    }
+
+    template <typename T>
+    schema_argument<T> schema_builder::add_value_argument(std::string_view n, std::string_view t)
+    {
+        return add<T>(n, t, detail::schema_kind::value, &detail::store_value<T>);
+    }
+
+    template <typename T>
+    schema_argument<std::pmr::vector<T>> schema_builder::add_multi_value_argument(std::string_view n, std::string_view t)
+    {
+        return add<std::pmr::vector<T>>(n, t, detail::schema_kind::multi_value, &detail::store_multi_value<T>);
+    }
+
+    inline schema_builder& schema_builder::set_limits(const parse_limits& l)
+    {
+        limits = l;
+        return *this;
+    }
+
+    inline frozen_schema schema_builder::freeze() &&
+    {
+        return frozen_schema(std::move(name), std::move(entries), std::move(validators), limits);
+    }
+
+    inline frozen_schema::frozen_schema(metadata_string n, std::vector<detail::schema_entry> e,
+        std::vector<std::function<bool(const void*)>> v, parse_limits l) :
+        name(std::move(n)),
+        entries(std::move(e)),
+        validators(std::move(v)),
+        tags(entries),
+        limits(l)
+    {
+        for (std::uint32_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].required)
+            {
+                required.push_back(i);
+            }
+        }
+    }
+
+#ifdef PX_HAS_SPAN
+    inline parse_result frozen_schema::parse(std::span<const std::string> args) const
+#else
+    inline parse_result frozen_schema::parse(const std::vector<std::string>& args) const
+#endif
+    {
+        parse_result result;
+        parse(args, result);
+        return result;
+    }
+
+#ifdef PX_HAS_SPAN
+    inline void frozen_schema::parse(std::span<const std::string> args, parse_result& result) const
+#else
+    inline void frozen_schema::parse(const std::vector<std::string>& args, parse_result& result) const
+#endif
+    {
+        store(args, result);
+        validate_required(result);
+        validate(result);
+    }
+
+#ifdef PX_HAS_SPAN
+    inline void frozen_schema::parse(std::span<const std::string_view> args, parse_result& result) const
+#else
+    inline void frozen_schema::parse(const std::vector<std::string_view>& args, parse_result& result) const
+#endif
+    {
+        store(args, result);
+        validate_required(result);
+        validate(result);
+    }
+
+    template <typename range>
+    void frozen_schema::store(const range& args, parse_result& result) const
+    {
+        detail::check_limits(args, limits);
+        result.clear();
+        detail::result_store store(result);
+
+        const auto end = args.end();
+        auto argv = args.begin();
+        if (argv != end)
+        {
+            ++argv;
+        }
+
+        for (; argv != end && !detail::is_separator_tag(*argv); ++argv)
+        {
+            const auto index = tags.find(entries, *argv);
+            if (index == detail::tag_index::npos)
+            {
+                continue;
+            }
+
+            const auto& entry = entries[index];
+            switch (entry.kind)
+            {
+            case detail::schema_kind::flag:
+                entry.store(store, index, *argv);
+                break;
+            case detail::schema_kind::value:
+                if (std::next(argv) == end)
+                {
+                    throw std::runtime_error(detail::concat({ "argument '", entry.name, "' requires a value" }));
+                }
+                entry.store(store, index, *++argv);
+                break;
+            case detail::schema_kind::multi_value:
+                for (; std::next(argv) != end && !detail::is_tag(*std::next(argv)); ++argv)
+                {
+                    entry.store(store, index, *std::next(argv));
+                }
+                break;
+            }
+        }
+    }
+
+    inline parse_result frozen_schema::parse(int argc, char** argv) const
+    {
+        return parse(std::vector<std::string>(argv, argv + argc));
+    }
+
+    inline void frozen_schema::validate_required(const parse_result& result) const
+    {
+        for (const auto index : required)
+        {
+            if (!result.has_value(schema_key<void>{ index }))
+            {
+                throw std::runtime_error(detail::concat({ "argument '", entries[index].name, "' invalid after parsing" }));
+            }
+        }
+    }
+
+    inline void frozen_schema::validate(const parse_result& result) const
+    {
+        for (auto i = std::size_t{ 0 }; i < result.size(); ++i)
+        {
+            const auto& s = result.slots[i];
+            const auto& entry = entries[s.index];
+            if (entry.validator != detail::schema_entry::no_validator && !validators[entry.validator](s.value))
+            {
+                throw std::runtime_error(detail::concat({ "argument '", entry.name, "' invalid after parsing" }));
+            }
+        }
+    }
+
+    inline void frozen_schema::print_help(help_sink& o) const
+    {
+        o.write(detail::concat({ name, "\n" }));
+        for (const auto& entry : entries)
+        {
+            o.write(detail::format_tag_help(entry.tag, entry.alternate_tag, entry.required, entry.description));
+        }
+        o.write("\n");
+    }
+
+#ifndef PX_NO_IOSTREAM
+    inline void frozen_schema::print_help(std::ostream& o) const
+    {
+        ostream_sink sink(o);
+        print_help(sink);
+    }
+#endif
+
+    inline std::size_t frozen_schema::size() const
+    {
+        return entries.size();
+    }
+
+    inline const parse_limits& frozen_schema::get_limits() const
+    {
+        return limits;
+    }
+}
+
+namespace px
+{
+    inline override_layer::override_layer(const frozen_schema& s, const parse_result& b) :
+        schema(&s),
+        base_result(&b)
+    {
+    }
+
+#ifdef PX_HAS_SPAN
+    inline void override_layer::parse(std::span<const std::string> args)
+#else
+    inline void override_layer::parse(const std::vector<std::string>& args)
+#endif
+    {
+        try
+        {
+            schema->store(args, overrides);
+            schema->validate(overrides);
+        }
+        catch (...)
+        {
+            overrides.clear();
+            throw;
+        }
+    }
+
+    template <typename T>
+    const T& override_layer::get(schema_key<T> key) const
+    {
+        if (const auto* value = overrides.find(key); value != nullptr)
+        {
+            return *value;
+        }
+        return base_result->get(key);
+    }
+
+    template <typename T>
+    const T* override_layer::find(schema_key<T> key) const
+    {
+        if (const auto* value = overrides.find(key); value != nullptr)
+        {
+            return value;
+        }
+        return base_result->find(key);
+    }
+
+    template <typename T>
+    bool override_layer::has_value(schema_key<T> key) const
+    {
+        return overrides.has_value(key) || base_result->has_value(key);
+    }
+
+    template <typename T>
+    bool override_layer::is_overridden(schema_key<T> key) const
+    {
+        return overrides.has_value(key);
+    }
+
+    inline std::size_t override_layer::size() const
+    {
+        return overrides.size();
+    }
+
+    inline void override_layer::clear()
+    {
+        overrides.clear();
+    }
+
+    inline const parse_result& override_layer::base() const
+    {
+        return *base_result;
+    }
+}
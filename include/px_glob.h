@@ -0,0 +1,580 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// glob patterns in path arguments, for callers that do not run a shell
+//
+//     cli.add_multi_value_argument<std::filesystem::path>("inputs", "-i")
+//         .set_expander(px::glob());
+//
+// a value such as data/**/*.parquet is replaced by the paths it matches:
+// * and ? match within a name, [a-z] and [!a-z] one character of a set,
+// ** any number of directories, and names starting with a dot only match
+// patterns that do. directories are read on a pool of threads, each
+// opened relative to its parent, and skipped when they cannot be read.
+// a pattern that matches nothing is an error, as values that are not
+// patterns are kept as given. the validator checks every path as it is
+// found, on the thread that found it
+
+#pragma once
+
+#include "px.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#if __has_include(<dirent.h>) && __has_include(<fcntl.h>)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#define PX_HAS_OPENAT
+#endif
+
+namespace px
+{
+    enum class glob_order { sorted, unsorted };
+
+    struct glob_options
+    {
+        // unsorted keeps the order in which the threads found the paths
+        glob_order order = glob_order::sorted;
+        // with threads 0, as many as the hardware has
+        std::size_t threads = 0;
+        // called concurrently; a path for which it returns false is an error
+        std::function<bool(const std::filesystem::path&)> validator;
+    };
+
+    // appends the paths matching the pattern, or the value if it is not one
+    void expand_glob(std::string_view pattern, std::vector<std::filesystem::path>&, const glob_options& = {});
+
+    // an expander for multi value path arguments
+    multi_scalar<std::filesystem::path>::expander glob(glob_options = {});
+}
+
+namespace detail
+{
+    inline bool has_glob(std::string_view s)
+    {
+        return s.find_first_of("*?[") != std::string_view::npos;
+    }
+
+    // the end of the set opening at pattern[open], or npos if it is not
+    // closed; matched tells whether c is in it
+    inline std::size_t glob_set(std::string_view pattern, std::size_t open, char c, bool& matched)
+    {
+        auto i = open + 1;
+        const auto negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+        if (negate)
+        {
+            ++i;
+        }
+        const auto u = static_cast<unsigned char>(c);
+        auto in = false;
+        for (auto first = true; i < pattern.size(); first = false)
+        {
+            if (pattern[i] == ']' && !first)
+            {
+                matched = (in != negate);
+                return i + 1;
+            }
+            const auto low = static_cast<unsigned char>(pattern[i]);
+            auto high = low;
+            if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']')
+            {
+                high = static_cast<unsigned char>(pattern[i + 2]);
+                i += 3;
+            }
+            else
+            {
+                ++i;
+            }
+            in = in || (low <= u && u <= high);
+        }
+        return std::string_view::npos;
+    }
+
+    // matches a name against the pattern of one path component
+    inline bool glob_match(std::string_view pattern, std::string_view name)
+    {
+        if (!name.empty() && name[0] == '.' && (pattern.empty() || pattern[0] != '.'))
+        {
+            return false;
+        }
+
+        // on a mismatch, the last * takes one more character
+        std::size_t p = 0;
+        std::size_t n = 0;
+        auto star = std::string_view::npos;
+        std::size_t star_n = 0;
+        while (n < name.size())
+        {
+            if (p < pattern.size())
+            {
+                const auto c = pattern[p];
+                if (c == '*')
+                {
+                    star = p++;
+                    star_n = n;
+                    continue;
+                }
+                if (c == '?')
+                {
+                    ++p;
+                    ++n;
+                    continue;
+                }
+                if (c == '[')
+                {
+                    auto matched = false;
+                    const auto next = glob_set(pattern, p, name[n], matched);
+                    if (next == std::string_view::npos ? name[n] == '[' : matched)
+                    {
+                        p = (next == std::string_view::npos) ? p + 1 : next;
+                        ++n;
+                        continue;
+                    }
+                }
+                else if (c == name[n])
+                {
+                    ++p;
+                    ++n;
+                    continue;
+                }
+            }
+            if (star == std::string_view::npos)
+            {
+                return false;
+            }
+            p = star + 1;
+            n = ++star_n;
+        }
+        while (p < pattern.size() && pattern[p] == '*')
+        {
+            ++p;
+        }
+        return p == pattern.size();
+    }
+
+    enum class glob_kind { file, directory, symlink, unknown };
+
+    // a directory being read, kept open while the directories in it are
+    // opened relative to it
+    struct glob_directory
+    {
+        glob_directory() = default;
+        glob_directory(const glob_directory&) = delete;
+        glob_directory& operator=(const glob_directory&) = delete;
+#ifdef PX_HAS_OPENAT
+        ~glob_directory()
+        {
+            if (dir != nullptr)
+            {
+                ::closedir(dir);
+            }
+        }
+
+        int fd() const
+        {
+            return (dir == nullptr) ? AT_FDCWD : ::dirfd(dir);
+        }
+
+        DIR* dir = nullptr;
+#endif
+        // the path as matched, empty or ending in a separator
+        std::string prefix;
+    };
+
+    // the directory name in parent, or nullptr if it cannot be read
+    inline std::shared_ptr<glob_directory> open_glob_directory(const glob_directory& parent, const std::string& name)
+    {
+        auto d = std::make_shared<glob_directory>();
+        d->prefix = concat({ parent.prefix, name, (name.back() == '/') ? "" : "/" });
+#ifdef PX_HAS_OPENAT
+        const auto fd = ::openat(parent.fd(), name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        d->dir = ::fdopendir(fd);
+        if (d->dir == nullptr)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+#else
+        std::error_code error;
+        if (!std::filesystem::is_directory(d->prefix, error))
+        {
+            return nullptr;
+        }
+#endif
+        return d;
+    }
+
+    inline bool glob_exists(const glob_directory& parent, const std::string& name)
+    {
+#ifdef PX_HAS_OPENAT
+        struct stat s;
+        return ::fstatat(parent.fd(), name.c_str(), &s, AT_SYMLINK_NOFOLLOW) == 0;
+#else
+        std::error_code error;
+        return std::filesystem::exists(std::filesystem::symlink_status(parent.prefix + name, error));
+#endif
+    }
+
+    // calls f(name, kind) for each entry of the directory, once
+    template <typename F>
+    void read_glob_directory(glob_directory& d, F&& f)
+    {
+#ifdef PX_HAS_OPENAT
+        while (const auto* entry = ::readdir(d.dir))
+        {
+            const std::string_view name(entry->d_name);
+            if (name == "." || name == "..")
+            {
+                continue;
+            }
+            auto kind = glob_kind::unknown;
+#ifdef DT_DIR
+            kind = (entry->d_type == DT_DIR) ? glob_kind::directory :
+                (entry->d_type == DT_LNK) ? glob_kind::symlink :
+                (entry->d_type == DT_UNKNOWN) ? glob_kind::unknown : glob_kind::file;
+#endif
+            if (kind == glob_kind::unknown)
+            {
+                struct stat s;
+                if (::fstatat(::dirfd(d.dir), entry->d_name, &s, AT_SYMLINK_NOFOLLOW) == 0)
+                {
+                    kind = S_ISDIR(s.st_mode) ? glob_kind::directory :
+                        S_ISLNK(s.st_mode) ? glob_kind::symlink : glob_kind::file;
+                }
+            }
+            f(name, kind);
+        }
+#else
+        std::error_code error;
+        for (std::filesystem::directory_iterator i(d.prefix.empty() ? "." : d.prefix, error), end; !error && i != end; i.increment(error))
+        {
+            const auto kind = i->is_symlink(error) ? glob_kind::symlink :
+                i->is_directory(error) ? glob_kind::directory : glob_kind::file;
+            f(i->path().filename().string(), kind);
+        }
+#endif
+    }
+
+    // matches the components of a pattern against the file system, one
+    // directory per task, on a pool of threads
+    class glob_walk
+    {
+    public:
+        glob_walk(std::string_view pattern, const px::glob_options& o) :
+            options(o)
+        {
+            std::size_t i = 0;
+            if (!pattern.empty() && pattern[0] == '/')
+            {
+                root = "/";
+                i = pattern.find_first_not_of('/');
+            }
+            while (i < pattern.size())
+            {
+                const auto slash = std::min(pattern.find('/', i), pattern.size());
+                const auto component = pattern.substr(i, slash - i);
+                // repeated ** match no more than one
+                if (!component.empty() && !(component == "**" && !components.empty() && components.back() == "**"))
+                {
+                    components.emplace_back(component);
+                }
+                i = slash + 1;
+            }
+        }
+
+        std::vector<std::vector<std::filesystem::path>> run()
+        {
+            const auto threads = std::max<std::size_t>(1, (options.threads == 0) ? std::thread::hardware_concurrency() : options.threads);
+            found.resize(threads);
+
+            // the root is read through a directory of its own, relative
+            // patterns starting in the working directory
+            const auto cwd = std::make_shared<glob_directory>();
+            if (const auto d = open_glob_directory(*cwd, root.empty() ? "." : root))
+            {
+                d->prefix = root;
+                push(d, 0);
+            }
+
+            std::vector<std::thread> workers;
+            for (std::size_t t = 1; t < threads; ++t)
+            {
+                workers.emplace_back(&glob_walk::work, this, t);
+            }
+            work(0);
+            for (auto& w : workers)
+            {
+                w.join();
+            }
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+            return std::move(found);
+        }
+
+    private:
+        struct task
+        {
+            std::shared_ptr<glob_directory> directory;
+            // the directory that contains it and its name, when it is not
+            // yet opened
+            std::shared_ptr<glob_directory> parent;
+            std::string name;
+            std::size_t component;
+        };
+
+        void push(std::shared_ptr<glob_directory> d, std::size_t component)
+        {
+            push(task{ std::move(d), nullptr, {}, component });
+        }
+
+        void push(std::shared_ptr<glob_directory> parent, std::string name, std::size_t component)
+        {
+            push(task{ nullptr, std::move(parent), std::move(name), component });
+        }
+
+        void push(task t)
+        {
+            {
+                std::lock_guard lock(mutex);
+                tasks.push_back(std::move(t));
+            }
+            queued.notify_one();
+        }
+
+        void work(std::size_t thread)
+        {
+            while (true)
+            {
+                task t;
+                {
+                    std::unique_lock lock(mutex);
+                    queued.wait(lock, [this] { return !tasks.empty() || busy == 0 || error; });
+                    if (tasks.empty() || error)
+                    {
+                        queued.notify_all();
+                        return;
+                    }
+                    t = std::move(tasks.front());
+                    tasks.pop_front();
+                    ++busy;
+                }
+
+                try
+                {
+                    run(t, found[thread]);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+
+                std::lock_guard lock(mutex);
+                if (--busy == 0 && tasks.empty())
+                {
+                    queued.notify_all();
+                }
+            }
+        }
+
+        void emit(std::string path, std::vector<std::filesystem::path>& out) const
+        {
+            std::filesystem::path p(std::move(path));
+            if (options.validator && !options.validator(p))
+            {
+                throw std::runtime_error(concat({ "path '", p.string(), "' is not valid" }));
+            }
+            out.push_back(std::move(p));
+        }
+
+        void run(task& t, std::vector<std::filesystem::path>& out)
+        {
+            if (!t.directory)
+            {
+                t.directory = open_glob_directory(*t.parent, t.name);
+                t.parent.reset();
+                if (!t.directory)
+                {
+                    return;
+                }
+            }
+            auto& d = *t.directory;
+            const auto c = t.component;
+            const auto last = components.size() - 1;
+
+            if (components[c] != "**")
+            {
+                if (!has_glob(components[c]))
+                {
+                    // a name is looked up rather than searched for
+                    if (c == last)
+                    {
+                        if (glob_exists(d, components[c]))
+                        {
+                            emit(d.prefix + components[c], out);
+                        }
+                    }
+                    else
+                    {
+                        push(t.directory, components[c], c + 1);
+                    }
+                    return;
+                }
+                read_glob_directory(d, [&](std::string_view name, glob_kind kind)
+                {
+                    if (glob_match(components[c], name))
+                    {
+                        descend(t.directory, name, kind, c, out);
+                    }
+                });
+                return;
+            }
+
+            // ** matches this directory, and each directory in it that is
+            // not hidden, followed without following symbolic links
+            read_glob_directory(d, [&](std::string_view name, glob_kind kind)
+            {
+                if (name[0] == '.' && (c == last || components[c + 1][0] != '.'))
+                {
+                    return;
+                }
+                if (kind == glob_kind::directory && name[0] != '.')
+                {
+                    push(t.directory, std::string(name), c);
+                }
+                if (c == last)
+                {
+                    emit(concat({ d.prefix, name }), out);
+                }
+                else if (has_glob(components[c + 1]) ? glob_match(components[c + 1], name) : name == components[c + 1])
+                {
+                    descend(t.directory, name, kind, c + 1, out);
+                }
+            });
+        }
+
+        // a name matched component c
+        void descend(const std::shared_ptr<glob_directory>& d, std::string_view name, glob_kind kind,
+            std::size_t c, std::vector<std::filesystem::path>& out)
+        {
+            if (c + 1 == components.size())
+            {
+                emit(concat({ d->prefix, name }), out);
+            }
+            else if (kind != glob_kind::file)
+            {
+                push(d, std::string(name), c + 1);
+            }
+        }
+
+        const px::glob_options& options;
+        std::string root;
+        std::vector<std::string> components;
+
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::deque<task> tasks;
+        std::size_t busy = 0;
+        std::exception_ptr error;
+        // found by each thread
+        std::vector<std::vector<std::filesystem::path>> found;
+    };
+}
+
+namespace px
+{
+    inline void expand_glob(std::string_view pattern, std::vector<std::filesystem::path>& paths, const glob_options& options)
+    {
+        if (!detail::has_glob(pattern))
+        {
+            std::filesystem::path p(pattern);
+            if (options.validator && !options.validator(p))
+            {
+                throw std::runtime_error(detail::concat({ "path '", pattern, "' is not valid" }));
+            }
+            paths.push_back(std::move(p));
+            return;
+        }
+
+        auto found = detail::glob_walk(pattern, options).run();
+        const auto first = paths.size();
+
+        // a path is matched more than once by a pattern with several **
+        if (options.order == glob_order::sorted)
+        {
+            for (auto& f : found)
+            {
+                paths.insert(paths.end(), std::make_move_iterator(f.begin()), std::make_move_iterator(f.end()));
+            }
+            const auto begin = paths.begin() + static_cast<std::ptrdiff_t>(first);
+            std::sort(begin, paths.end());
+            paths.erase(std::unique(begin, paths.end()), paths.end());
+        }
+        else
+        {
+            // the views are of the paths kept, which do not move once
+            // reserved for
+            std::size_t count = 0;
+            for (const auto& f : found)
+            {
+                count += f.size();
+            }
+            paths.reserve(paths.size() + count);
+            std::unordered_set<std::string_view> seen;
+            for (auto& f : found)
+            {
+                for (auto& p : f)
+                {
+                    paths.push_back(std::move(p));
+                    if (!seen.insert(paths.back().native()).second)
+                    {
+                        paths.pop_back();
+                    }
+                }
+            }
+        }
+        if (paths.size() == first)
+        {
+            throw std::runtime_error(detail::concat({ "no paths match '", pattern, "'" }));
+        }
+    }
+
+    inline multi_scalar<std::filesystem::path>::expander glob(glob_options options)
+    {
+        return [options = std::move(options)](std::string_view pattern, std::vector<std::filesystem::path>& paths)
+        {
+            expand_glob(pattern, paths, options);
+        };
+    }
+}
@@ -0,0 +1,485 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// a command line whose arguments are members of a struct, and which can be
+// parsed in constant evaluation; a preset written as a string literal is
+// then parsed and validated by the compiler:
+//
+//     struct settings { int threads = 1; bool verbose = false; };
+//     constexpr px::static_command_line cli(
+//         px::static_argument("-t", &settings::threads)
+//             .set_validator([](int t) { return t > 0; }),
+//         px::static_argument("-v", &settings::verbose));
+//     constexpr settings fast = cli.parse("-t 8 -v");
+//
+// an invalid preset fails to compile, naming one of the error functions
+// below in the diagnostic. values can be integral, floating point, bool or
+// std::string_view; a bool member is a flag. string_view values refer into
+// the parsed text, so they are valid as long as that text is
+
+#pragma once
+
+#include "px_tokenize.h"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail
+{
+    // these are deliberately not constexpr: reaching one in constant
+    // evaluation is what makes an invalid preset fail to compile
+    [[noreturn]] inline void preset_unknown_argument(std::string_view s)
+    {
+        throw std::runtime_error("unknown argument '" + std::string(s) + "'");
+    }
+
+    [[noreturn]] inline void preset_missing_value(std::string_view tag)
+    {
+        throw std::runtime_error("argument '" + std::string(tag) + "' requires a value");
+    }
+
+    [[noreturn]] inline void preset_could_not_parse(std::string_view s)
+    {
+        throw std::runtime_error("could not parse from '" + std::string(s) + "'");
+    }
+
+    [[noreturn]] inline void preset_invalid_argument(std::string_view tag)
+    {
+        throw std::runtime_error("argument '" + std::string(tag) + "' invalid after parsing");
+    }
+
+    [[noreturn]] inline void preset_missing_required_argument(std::string_view tag)
+    {
+        throw std::runtime_error("argument '" + std::string(tag) + "' is required");
+    }
+
+    template <typename T, typename wide>
+    constexpr wide negative_limit()
+    {
+        if constexpr (std::is_signed_v<T>)
+        {
+            return static_cast<wide>(std::numeric_limits<T>::min());
+        }
+        else
+        {
+            return static_cast<wide>(std::numeric_limits<T>::max());
+        }
+    }
+
+    template <typename T>
+    constexpr T parse_preset_integral(std::string_view s)
+    {
+        auto negative = false;
+        auto i = std::size_t{0};
+        if (!s.empty() && (s[0] == '-' || s[0] == '+'))
+        {
+            negative = s[0] == '-';
+            ++i;
+        }
+        if (i == s.size() || (negative && std::is_unsigned_v<T>))
+        {
+            preset_could_not_parse(s);
+        }
+
+        // accumulate negatively, so that the minimum of T is representable
+        using wide = std::conditional_t<std::is_signed_v<T>, std::intmax_t, std::uintmax_t>;
+        constexpr auto limit = negative_limit<T, wide>();
+        wide value = 0;
+        for (; i < s.size(); ++i)
+        {
+            if (s[i] < '0' || s[i] > '9')
+            {
+                preset_could_not_parse(s);
+            }
+            const auto digit = static_cast<wide>(s[i] - '0');
+            if constexpr (std::is_signed_v<T>)
+            {
+                if (value < (limit + digit) / 10)
+                {
+                    preset_could_not_parse(s);
+                }
+                value = value * 10 - digit;
+            }
+            else
+            {
+                if (value > (limit - digit) / 10)
+                {
+                    preset_could_not_parse(s);
+                }
+                value = value * 10 + digit;
+            }
+        }
+
+        if constexpr (std::is_signed_v<T>)
+        {
+            if (!negative)
+            {
+                if (value < -static_cast<wide>(std::numeric_limits<T>::max()))
+                {
+                    preset_could_not_parse(s);
+                }
+                value = -value;
+            }
+        }
+        return static_cast<T>(value);
+    }
+
+    // at run time, from_chars; in constant evaluation, where it is not
+    // available, only values that are exactly representable as a mantissa
+    // of at most 53 bits times a power of ten up to 22 are accepted. for
+    // those, a single multiplication or division is correctly rounded, so
+    // the result equals what from_chars produces
+    template <typename T>
+    constexpr T parse_preset_floating(std::string_view s)
+    {
+        if (!std::is_constant_evaluated())
+        {
+            // from_chars takes no plus sign
+            const auto text = (s.size() > 1 && s[0] == '+' && s[1] != '-') ? s.substr(1) : s;
+            T value{};
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc() || end != text.data() + text.size())
+            {
+                preset_could_not_parse(s);
+            }
+            return value;
+        }
+
+        constexpr double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        constexpr auto max_exact_mantissa = std::uint64_t{1} << 53;
+
+        auto negative = false;
+        auto i = std::size_t{0};
+        if (!s.empty() && (s[0] == '-' || s[0] == '+'))
+        {
+            negative = s[0] == '-';
+            ++i;
+        }
+
+        std::uint64_t mantissa = 0;
+        auto exponent = 0;
+        auto digits = 0;
+        auto point = false;
+        for (; i < s.size() && s[i] != 'e' && s[i] != 'E'; ++i)
+        {
+            if (s[i] == '.' && !point)
+            {
+                point = true;
+            }
+            else if (s[i] >= '0' && s[i] <= '9')
+            {
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(s[i] - '0');
+                exponent -= (point) ? 1 : 0;
+                if (++digits > 16 || mantissa > max_exact_mantissa)
+                {
+                    preset_could_not_parse(s);
+                }
+            }
+            else
+            {
+                preset_could_not_parse(s);
+            }
+        }
+        if (digits == 0)
+        {
+            preset_could_not_parse(s);
+        }
+        if (i < s.size())
+        {
+            exponent += parse_preset_integral<int>(s.substr(i + 1));
+        }
+
+        if (exponent < -22 || exponent > 22)
+        {
+            preset_could_not_parse(s);
+        }
+        auto value = static_cast<double>(mantissa);
+        value = (exponent < 0) ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+        return static_cast<T>((negative) ? -value : value);
+    }
+
+    constexpr bool parse_preset_bool(std::string_view s)
+    {
+        if (s == "1" || s == "true")
+        {
+            return true;
+        }
+        else if (s == "0" || s == "false")
+        {
+            return false;
+        }
+        preset_could_not_parse(s);
+    }
+
+    template <typename T>
+    constexpr T parse_preset_value(std::string_view s)
+    {
+        if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            return s;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return parse_preset_bool(s);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            return parse_preset_floating<T>(s);
+        }
+        else
+        {
+            static_assert(std::is_integral_v<T>,
+                "static arguments must be integral, floating point, bool or std::string_view");
+            return parse_preset_integral<T>(s);
+        }
+    }
+
+    struct always_valid
+    {
+        template <typename T>
+        constexpr bool operator()(const T&) const { return true; }
+    };
+
+    template <typename>
+    struct member_traits;
+
+    template <typename C, typename T>
+    struct member_traits<T C::*>
+    {
+        using class_type = C;
+        using value_type = T;
+    };
+}
+
+namespace px
+{
+    template <typename Member, typename Validator = detail::always_valid>
+    class static_argument
+    {
+    public:
+        using class_type = typename detail::member_traits<Member>::class_type;
+        using value_type = typename detail::member_traits<Member>::value_type;
+
+        constexpr static_argument(std::string_view t, Member m, Validator v = {});
+
+        constexpr static_argument set_alternate_tag(std::string_view) const;
+        constexpr static_argument set_required(bool) const;
+        template <typename F>
+        constexpr static_argument<Member, F> set_validator(F) const;
+
+        constexpr const std::string_view& get_tag() const;
+        constexpr bool is_flag() const;
+        constexpr bool matches(std::string_view) const;
+        constexpr void consume(class_type&, const std::vector<std::string_view>&, std::size_t&) const;
+        constexpr void validate(const class_type&, bool given) const;
+
+    private:
+        template <typename, typename>
+        friend class static_argument;
+
+        std::string_view tag;
+        std::string_view alternate_tag;
+        Member member;
+        Validator validator;
+        bool required = false;
+    };
+
+    template <typename... Arguments>
+    class static_command_line
+    {
+    public:
+        using result_type = typename std::tuple_element_t<0, std::tuple<Arguments...>>::class_type;
+        static_assert((std::is_same_v<result_type, typename Arguments::class_type> && ...),
+            "all arguments of a static command line must be members of the same class");
+
+        constexpr static_command_line(Arguments... a);
+
+        constexpr result_type parse(std::string_view) const;
+        constexpr result_type parse(const std::vector<std::string_view>&) const;
+        result_type parse(int argc, char** argv) const;
+
+    private:
+        template <std::size_t I>
+        constexpr bool dispatch(result_type&, std::array<bool, sizeof...(Arguments)>&,
+            const std::vector<std::string_view>&, std::size_t&) const;
+
+        std::tuple<Arguments...> arguments;
+    };
+
+    template <typename Member, typename Validator>
+    constexpr static_argument<Member, Validator>::static_argument(std::string_view t, Member m, Validator v) :
+        tag(t),
+        member(m),
+        validator(v)
+    {
+    }
+
+    template <typename Member, typename Validator>
+    constexpr static_argument<Member, Validator>
+        static_argument<Member, Validator>::set_alternate_tag(std::string_view t) const
+    {
+        auto copy = *this;
+        copy.alternate_tag = t;
+        return copy;
+    }
+
+    template <typename Member, typename Validator>
+    constexpr static_argument<Member, Validator>
+        static_argument<Member, Validator>::set_required(bool r) const
+    {
+        auto copy = *this;
+        copy.required = r;
+        return copy;
+    }
+
+    template <typename Member, typename Validator>
+    template <typename F>
+    constexpr static_argument<Member, F> static_argument<Member, Validator>::set_validator(F f) const
+    {
+        static_argument<Member, F> copy(tag, member, f);
+        copy.alternate_tag = alternate_tag;
+        copy.required = required;
+        return copy;
+    }
+
+    template <typename Member, typename Validator>
+    constexpr const std::string_view& static_argument<Member, Validator>::get_tag() const
+    {
+        return tag;
+    }
+
+    template <typename Member, typename Validator>
+    constexpr bool static_argument<Member, Validator>::is_flag() const
+    {
+        return std::is_same_v<value_type, bool>;
+    }
+
+    template <typename Member, typename Validator>
+    constexpr bool static_argument<Member, Validator>::matches(std::string_view s) const
+    {
+        return (!tag.empty() && tag == s) || (!alternate_tag.empty() && alternate_tag == s);
+    }
+
+    template <typename Member, typename Validator>
+    constexpr void static_argument<Member, Validator>::consume(class_type& c,
+        const std::vector<std::string_view>& tokens, std::size_t& i) const
+    {
+        if constexpr (std::is_same_v<value_type, bool>)
+        {
+            c.*member = true;
+        }
+        else
+        {
+            if (i + 1 == tokens.size())
+            {
+                detail::preset_missing_value(tokens[i]);
+            }
+            c.*member = detail::parse_preset_value<value_type>(tokens[++i]);
+        }
+    }
+
+    template <typename Member, typename Validator>
+    constexpr void static_argument<Member, Validator>::validate(const class_type& c, bool given) const
+    {
+        if (given && !validator(c.*member))
+        {
+            detail::preset_invalid_argument(tag);
+        }
+        else if (!given && required)
+        {
+            detail::preset_missing_required_argument(tag);
+        }
+    }
+
+    template <typename... Arguments>
+    static_command_line(Arguments...) -> static_command_line<Arguments...>;
+
+    template <typename... Arguments>
+    constexpr static_command_line<Arguments...>::static_command_line(Arguments... a) :
+        arguments(a...)
+    {
+    }
+
+    template <typename... Arguments>
+    template <std::size_t I>
+    constexpr bool static_command_line<Arguments...>::dispatch(result_type& result,
+        std::array<bool, sizeof...(Arguments)>& given,
+        const std::vector<std::string_view>& tokens, std::size_t& i) const
+    {
+        const auto& arg = std::get<I>(arguments);
+        if (arg.matches(tokens[i]))
+        {
+            arg.consume(result, tokens, i);
+            given[I] = true;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename... Arguments>
+    constexpr typename static_command_line<Arguments...>::result_type
+        static_command_line<Arguments...>::parse(const std::vector<std::string_view>& tokens) const
+    {
+        result_type result{};
+        std::array<bool, sizeof...(Arguments)> given{};
+        constexpr auto indices = std::index_sequence_for<Arguments...>{};
+
+        for (std::size_t i = 0; i < tokens.size(); ++i)
+        {
+            const auto matched = [&]<std::size_t... I>(std::index_sequence<I...>)
+            {
+                return (dispatch<I>(result, given, tokens, i) || ...);
+            }(indices);
+            if (!matched)
+            {
+                detail::preset_unknown_argument(tokens[i]);
+            }
+        }
+
+        [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            (std::get<I>(arguments).validate(result, given[I]), ...);
+        }(indices);
+        return result;
+    }
+
+    template <typename... Arguments>
+    constexpr typename static_command_line<Arguments...>::result_type
+        static_command_line<Arguments...>::parse(std::string_view command) const
+    {
+        return parse(detail::tokenize_preset(command));
+    }
+
+    template <typename... Arguments>
+    typename static_command_line<Arguments...>::result_type
+        static_command_line<Arguments...>::parse(int argc, char** argv) const
+    {
+        // the first argument is the program name
+        return parse(std::vector<std::string_view>(argv + ((argc > 0) ? 1 : 0), argv + argc));
+    }
+}
@@ -0,0 +1,519 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// arguments of a frozen schema read from a config file that can change
+// while the program runs
+//
+// the config file holds arguments as they would be given on the command
+// line, separated by white space or newlines, quoted with ' or " and with
+// lines starting with # ignored. a config_reloader parses it, validates it
+// and publishes the values of bound arguments to published<T> cells, which
+// readers on other threads load without waiting for a reload:
+//
+//     px::config_reloader config(schema, "tool.conf");
+//     const auto& threads = config.bind(threads_key, 1);
+//     config.reload();
+//     config.watch();
+//     ...
+//     const auto n = threads.load();
+//
+// a lock free trivially copyable value is loaded with a single atomic load.
+// other values are snapshots behind a shared_ptr, and loading one takes the
+// atomic<shared_ptr> load: a short spin lock on the pointer and a reference
+// count increment, or a lock from a mutex pool where the library has no
+// atomic<shared_ptr>. readers that load often keep the snapshot a while.
+//
+// an invalid config file is not published; the previous values are kept.
+// a file that is rewritten in place can be read half written, so replace
+// it by renaming a complete file over it
+
+#pragma once
+
+#include "px_frozen.h"
+#include "px_tokenize.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace detail
+{
+    // trivially copyable values are published in a std::atomic, others
+    // through a pointer to an immutable snapshot
+    template <typename T>
+    constexpr bool atomic_publishable()
+    {
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            return std::atomic<T>::is_always_lock_free;
+        }
+        return false;
+    }
+
+    template <typename T>
+    constexpr bool is_atomic_publishable = atomic_publishable<T>();
+
+    template <typename T>
+    class snapshot_pointer
+    {
+    public:
+        explicit snapshot_pointer(std::shared_ptr<const T> p) : pointer(std::move(p)) {}
+
+        std::shared_ptr<const T> load() const
+        {
+#ifdef __cpp_lib_atomic_shared_ptr
+            return pointer.load(std::memory_order_acquire);
+#else
+            return std::atomic_load_explicit(&pointer, std::memory_order_acquire);
+#endif
+        }
+
+        void store(std::shared_ptr<const T> p)
+        {
+#ifdef __cpp_lib_atomic_shared_ptr
+            pointer.store(std::move(p), std::memory_order_release);
+#else
+            std::atomic_store_explicit(&pointer, std::move(p), std::memory_order_release);
+#endif
+        }
+
+    private:
+#ifdef __cpp_lib_atomic_shared_ptr
+        std::atomic<std::shared_ptr<const T>> pointer;
+#else
+        std::shared_ptr<const T> pointer;
+#endif
+    };
+
+    // the arguments in a config file, preceded by an empty program name
+    inline std::vector<std::string> tokenize_config(std::string_view text)
+    {
+        std::vector<std::string> args(1);
+        while (!text.empty())
+        {
+            const auto end = text.find('\n');
+            auto line = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+            const auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string_view::npos || line[first] == '#')
+            {
+                continue;
+            }
+            for (const auto token : tokenize_preset(line))
+            {
+                args.emplace_back(token);
+            }
+        }
+        return args;
+    }
+
+    struct file_stamp
+    {
+        std::filesystem::file_time_type time;
+        std::uintmax_t size = 0;
+
+        bool operator==(const file_stamp&) const = default;
+    };
+
+    inline std::optional<file_stamp> stamp_of(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(path, error);
+        if (error)
+        {
+            return std::nullopt;
+        }
+        const auto size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            return std::nullopt;
+        }
+        return file_stamp{ time, size };
+    }
+}
+
+namespace px
+{
+    // the current value of a reloadable argument
+    template <typename T>
+    class published
+    {
+    public:
+        explicit published(T);
+        published(const published&) = delete;
+        published& operator=(const published&) = delete;
+
+        // a copy of the value for trivially copyable types, one atomic load;
+        // a pointer to an immutable snapshot for others, which locks the
+        // pointer briefly and counts a reference
+        auto load() const;
+        void store(T);
+
+    private:
+        using storage = std::conditional_t<detail::is_atomic_publishable<T>,
+            std::atomic<T>, detail::snapshot_pointer<T>>;
+
+        storage value;
+    };
+}
+
+namespace detail
+{
+    class ibinding
+    {
+    public:
+        virtual ~ibinding() = default;
+        // publishes the value in next when it differs from the one in
+        // previous, which is null on the first load
+        virtual bool publish(const px::parse_result* previous, const px::parse_result& next) = 0;
+    };
+
+    template <typename T>
+    class binding : public ibinding
+    {
+    public:
+        binding(px::schema_key<T> k, T f) : key(k), fallback(f), value(std::move(f)) {}
+
+        bool publish(const px::parse_result* previous, const px::parse_result& next) override
+        {
+            const auto* before = (previous != nullptr) ? previous->find(key) : nullptr;
+            const auto* after = next.find(key);
+            if (previous != nullptr && ((before == nullptr && after == nullptr) ||
+                (before != nullptr && after != nullptr && *before == *after)))
+            {
+                return false;
+            }
+            value.store(after != nullptr ? *after : fallback);
+            return true;
+        }
+
+        px::schema_key<T> key;
+        T fallback;
+        px::published<T> value;
+    };
+}
+
+namespace px
+{
+    class config_reloader
+    {
+    public:
+        config_reloader(const frozen_schema&, std::filesystem::path);
+        config_reloader(const config_reloader&) = delete;
+        config_reloader& operator=(const config_reloader&) = delete;
+        ~config_reloader();
+
+        // the published value of an argument, which is the fallback while the
+        // argument is not in the config file. the reloader must outlive it
+        template <typename T>
+        const published<T>& bind(schema_key<T>, T fallback);
+
+        // reads, parses and validates the config file and publishes the
+        // values that changed; returns whether any did. throws when the file
+        // cannot be read or is invalid, and then keeps the previous values
+        bool reload();
+        // reloads when the modification time or size of the file changed
+        bool poll();
+
+        // all values of the last successful reload, for readers that need
+        // several values to be consistent with each other
+        std::shared_ptr<const parse_result> snapshot() const;
+
+        // reloads on a background thread whenever the file changes, through
+        // inotify where available and by polling at the interval otherwise;
+        // errors are passed to the handler and do not stop watching
+        void watch(std::function<void(std::exception_ptr)> on_error = {},
+            std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+        void stop();
+
+    private:
+        void run(std::function<void(std::exception_ptr)>, std::chrono::milliseconds);
+
+        const frozen_schema& schema;
+        std::filesystem::path path;
+        std::vector<std::unique_ptr<detail::ibinding>> bindings;
+        detail::snapshot_pointer<parse_result> current{ nullptr };
+        std::string text;
+        std::optional<detail::file_stamp> stamp;
+        mutable std::mutex reloading;
+
+        std::thread watcher;
+#ifdef __linux__
+        int notify_fd = -1;
+        // written by stop, to wake the watcher from its wait on inotify
+        int wake_fd = -1;
+#endif
+        std::mutex stopping;
+        std::condition_variable stopped;
+        bool stop_requested = false;
+    };
+}
+
+namespace px
+{
+    template <typename T>
+    published<T>::published(T t) :
+        value([&]() -> storage
+            {
+                if constexpr (detail::is_atomic_publishable<T>)
+                {
+                    return storage(t);
+                }
+                else
+                {
+                    return storage(std::make_shared<const T>(std::move(t)));
+                }
+            }())
+    {
+    }
+
+    template <typename T>
+    auto published<T>::load() const
+    {
+        if constexpr (detail::is_atomic_publishable<T>)
+        {
+            return value.load(std::memory_order_acquire);
+        }
+        else
+        {
+            return value.load();
+        }
+    }
+
+    template <typename T>
+    void published<T>::store(T t)
+    {
+        if constexpr (detail::is_atomic_publishable<T>)
+        {
+            value.store(t, std::memory_order_release);
+        }
+        else
+        {
+            value.store(std::make_shared<const T>(std::move(t)));
+        }
+    }
+
+    inline config_reloader::config_reloader(const frozen_schema& s, std::filesystem::path p) :
+        schema(s),
+        path(std::move(p))
+    {
+    }
+
+    inline config_reloader::~config_reloader()
+    {
+        stop();
+    }
+
+    template <typename T>
+    const published<T>& config_reloader::bind(schema_key<T> key, T fallback)
+    {
+        std::lock_guard lock(reloading);
+        auto b = std::make_unique<detail::binding<T>>(key, std::move(fallback));
+        if (const auto values = current.load(); values != nullptr)
+        {
+            b->publish(nullptr, *values);
+        }
+        auto& value = b->value;
+        bindings.push_back(std::move(b));
+        return value;
+    }
+
+    inline bool config_reloader::reload()
+    {
+        std::lock_guard lock(reloading);
+        const auto new_stamp = detail::stamp_of(path);
+        auto new_text = detail::read_file(path.string());
+        if (!new_text)
+        {
+            throw std::runtime_error(detail::concat({ "could not read config file '", path.string(), "'" }));
+        }
+
+        auto previous = current.load();
+        if (previous != nullptr && *new_text == text)
+        {
+            stamp = new_stamp;
+            return false;
+        }
+
+        auto next = std::make_shared<parse_result>();
+        schema.parse(detail::tokenize_config(*new_text), *next);
+
+        auto changed = false;
+        for (auto& b : bindings)
+        {
+            changed = b->publish(previous.get(), *next) || changed;
+        }
+        current.store(std::move(next));
+        text = std::move(*new_text);
+        stamp = new_stamp;
+        return changed;
+    }
+
+    inline bool config_reloader::poll()
+    {
+        {
+            std::lock_guard lock(reloading);
+            if (const auto s = detail::stamp_of(path); s && s == stamp)
+            {
+                return false;
+            }
+        }
+        return reload();
+    }
+
+    inline std::shared_ptr<const parse_result> config_reloader::snapshot() const
+    {
+        return current.load();
+    }
+
+    inline void config_reloader::watch(std::function<void(std::exception_ptr)> on_error,
+        std::chrono::milliseconds interval)
+    {
+        if (watcher.joinable())
+        {
+            throw std::logic_error("config file is already watched");
+        }
+        stop_requested = false;
+#ifdef __linux__
+        // set up before returning, so that no change is missed; editors
+        // replace files by renaming, so the directory is watched
+        notify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        const auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+        if (notify_fd >= 0 && ::inotify_add_watch(notify_fd, directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) < 0)
+        {
+            ::close(notify_fd);
+            notify_fd = -1;
+        }
+        if (notify_fd >= 0)
+        {
+            wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (wake_fd < 0)
+            {
+                ::close(notify_fd);
+                notify_fd = -1;
+            }
+        }
+#endif
+        watcher = std::thread(&config_reloader::run, this, std::move(on_error), interval);
+    }
+
+    inline void config_reloader::stop()
+    {
+        {
+            std::lock_guard lock(stopping);
+            stop_requested = true;
+        }
+        stopped.notify_all();
+#ifdef __linux__
+        if (wake_fd >= 0)
+        {
+            const std::uint64_t one = 1;
+            while (::write(wake_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+            {
+            }
+        }
+#endif
+        if (watcher.joinable())
+        {
+            watcher.join();
+        }
+#ifdef __linux__
+        for (auto* fd : { &notify_fd, &wake_fd })
+        {
+            if (*fd >= 0)
+            {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+#endif
+    }
+
+    inline void config_reloader::run(std::function<void(std::exception_ptr)> on_error,
+        std::chrono::milliseconds interval)
+    {
+#ifdef __linux__
+        const auto fd = notify_fd;
+        const auto wake = wake_fd;
+#endif
+        while (true)
+        {
+            // an inotify event means the file may have changed within the
+            // resolution of its time stamp, so it is compared by content
+            auto notified = false;
+            {
+                std::unique_lock lock(stopping);
+#ifdef __linux__
+                if (fd >= 0)
+                {
+                    // waits on inotify and on stop, without a timeout
+                    lock.unlock();
+                    pollfd p[2] = { { fd, POLLIN, 0 }, { wake, POLLIN, 0 } };
+                    if (::poll(p, 2, -1) > 0 && (p[0].revents & POLLIN) != 0)
+                    {
+                        char events[4096];
+                        while (::read(fd, events, sizeof(events)) > 0)
+                        {
+                        }
+                        notified = true;
+                    }
+                    lock.lock();
+                }
+                else
+#endif
+                {
+                    stopped.wait_for(lock, interval, [this] { return stop_requested; });
+                }
+                if (stop_requested)
+                {
+                    break;
+                }
+            }
+
+            try
+            {
+#ifdef __linux__
+                if (fd >= 0 && !notified)
+                {
+                    continue;
+                }
+#endif
+                notified ? reload() : poll();
+            }
+            catch (...)
+            {
+                if (on_error)
+                {
+                    on_error(std::current_exception());
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,294 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// response files: an argument @path stands for the arguments in the file
+// at path, separated by white space and quoted with ' or " as in presets
+//
+//     px::response_files files(limits);
+//     const auto args = files.expand(std::span(argv, argc));
+//     schema.parse(args, result);
+//
+// files are mapped rather than read, and the arguments are views into the
+// mapping, valid as long as the response_files; arguments that are not
+// expanded are views of the ones given. a large file is split into
+// chunks at newlines that are tokenized in parallel; a quoted argument that
+// spans chunks is resolved afterwards, so the arguments, their order and
+// the position reported for an unterminated quote are those of tokenizing
+// the file from start to end
+
+#pragma once
+
+#include "px.h"
+#include "px_preset.h"
+
+#include <filesystem>
+#include <thread>
+
+namespace detail
+{
+    [[noreturn]] inline void throw_unterminated_quote(std::size_t position)
+    {
+        throw std::runtime_error(concat({ "unterminated quote at byte ", std::to_string(position) }));
+    }
+
+    // appends the arguments in text[begin, end) and returns the position of
+    // a quote that is not closed before end, or npos
+    inline std::size_t tokenize_response(std::string_view text, std::size_t begin, std::size_t end,
+        std::vector<std::string_view>& tokens)
+    {
+        const auto chunk = text.substr(0, end);
+        auto i = begin;
+        while (i < end)
+        {
+            const auto c = text[i];
+            if (is_preset_space(c))
+            {
+                ++i;
+            }
+            else if (c == '\'' || c == '"')
+            {
+                const auto close = chunk.find(c, i + 1);
+                if (close == std::string_view::npos)
+                {
+                    return i;
+                }
+                tokens.push_back(text.substr(i + 1, close - i - 1));
+                i = close + 1;
+            }
+            else
+            {
+                auto j = i;
+                while (j < end && !is_preset_space(text[j]))
+                {
+                    ++j;
+                }
+                tokens.push_back(text.substr(i, j - i));
+                i = j;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    // the arguments in text, tokenized in chunks of at least min_chunk bytes
+    // on up to the given number of threads
+    inline std::vector<std::string_view> tokenize_response_parallel(std::string_view text,
+        std::size_t threads, std::size_t min_chunk = 1 << 20)
+    {
+        // chunks start after a newline, so no unquoted argument spans two
+        std::vector<std::size_t> bounds{ 0 };
+        const auto n = std::max<std::size_t>(1, std::min(threads, text.size() / std::max<std::size_t>(1, min_chunk)));
+        for (std::size_t k = 1; k < n; ++k)
+        {
+            const auto newline = text.find('\n', std::max(k * text.size() / n, bounds.back()));
+            if (newline == std::string_view::npos)
+            {
+                break;
+            }
+            if (newline + 1 < text.size())
+            {
+                bounds.push_back(newline + 1);
+            }
+        }
+        bounds.push_back(text.size());
+        const auto chunks = bounds.size() - 1;
+
+        // each chunk is tokenized as if it started outside quotes
+        std::vector<std::vector<std::string_view>> tokens(chunks);
+        std::vector<std::size_t> open(chunks);
+        {
+            std::vector<std::thread> workers;
+            for (std::size_t k = 1; k < chunks; ++k)
+            {
+                workers.emplace_back([&, k] { open[k] = tokenize_response(text, bounds[k], bounds[k + 1], tokens[k]); });
+            }
+            open[0] = tokenize_response(text, bounds[0], bounds[1], tokens[0]);
+            for (auto& w : workers)
+            {
+                w.join();
+            }
+        }
+
+        // where a chunk ends within quotes, the next chunks are tokenized
+        // again from the quote, until a chunk ends outside quotes
+        std::vector<const std::vector<std::string_view>*> pieces;
+        std::vector<std::vector<std::string_view>> retokenized;
+        retokenized.reserve(chunks);
+        for (std::size_t k = 0; k < chunks;)
+        {
+            pieces.push_back(&tokens[k]);
+            auto quote = open[k++];
+            while (quote != std::string_view::npos)
+            {
+                if (k == chunks)
+                {
+                    throw_unterminated_quote(quote);
+                }
+                auto& again = retokenized.emplace_back();
+                quote = tokenize_response(text, quote, bounds[k + 1], again);
+                pieces.push_back(&again);
+                ++k;
+            }
+        }
+
+        if (pieces.size() == 1)
+        {
+            return std::move(tokens[0]);
+        }
+
+        // merged in order, each piece copied by its own thread
+        std::vector<std::size_t> offsets{ 0 };
+        for (const auto* piece : pieces)
+        {
+            offsets.push_back(offsets.back() + piece->size());
+        }
+        std::vector<std::string_view> merged(offsets.back());
+        {
+            std::vector<std::thread> workers;
+            for (std::size_t p = 1; p < pieces.size(); ++p)
+            {
+                workers.emplace_back([&, p] { std::copy(pieces[p]->begin(), pieces[p]->end(), merged.begin() + offsets[p]); });
+            }
+            std::copy(pieces[0]->begin(), pieces[0]->end(), merged.begin());
+            for (auto& w : workers)
+            {
+                w.join();
+            }
+        }
+        return merged;
+    }
+}
+
+namespace px
+{
+    // the arguments in one response file
+    class response_file
+    {
+    public:
+        // with threads 0, as many as the hardware has
+        explicit response_file(const std::filesystem::path&, std::size_t threads = 0);
+
+        const std::vector<std::string_view>& get_tokens() const;
+
+    private:
+        mapped_file file;
+        std::vector<std::string_view> tokens;
+    };
+
+    // expands the response files in arguments, and keeps them mapped
+    class response_files
+    {
+    public:
+        // limits.max_include_depth bounds response files naming others
+        explicit response_files(const parse_limits& = {}, std::size_t threads = 0);
+
+        // the arguments with each @path, other than the program name and the
+        // arguments after a separator, replaced by the arguments in the file
+        template <typename range>
+        std::vector<std::string_view> expand(const range& args);
+
+    private:
+        void expand(std::string_view, std::vector<std::string_view>&, std::size_t depth);
+
+        parse_limits limits;
+        std::size_t threads;
+        std::vector<std::unique_ptr<response_file>> files;
+        // the files being expanded, to find files that name themselves
+        std::vector<std::filesystem::path> including;
+    };
+}
+
+namespace px
+{
+    inline response_file::response_file(const std::filesystem::path& path, std::size_t threads) :
+        file(path.string())
+    {
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        try
+        {
+            tokens = detail::tokenize_response_parallel(file.get_text(), threads);
+        }
+        catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error(detail::concat({ e.what(), " of response file '", path.string(), "'" }));
+        }
+    }
+
+    inline const std::vector<std::string_view>& response_file::get_tokens() const
+    {
+        return tokens;
+    }
+
+    inline response_files::response_files(const parse_limits& l, std::size_t t) :
+        limits(l),
+        threads(t)
+    {
+    }
+
+    template <typename range>
+    std::vector<std::string_view> response_files::expand(const range& args)
+    {
+        including.clear();
+        std::vector<std::string_view> expanded;
+        auto i = std::begin(args);
+        if (i != std::end(args))
+        {
+            expanded.emplace_back(*i++);
+        }
+        for (; i != std::end(args); ++i)
+        {
+            const std::string_view arg(*i);
+            if (detail::is_separator_tag(arg))
+            {
+                expanded.insert(expanded.end(), i, std::end(args));
+                break;
+            }
+            expand(arg, expanded, 0);
+        }
+        return expanded;
+    }
+
+    inline void response_files::expand(std::string_view arg, std::vector<std::string_view>& expanded, std::size_t depth)
+    {
+        if (arg.size() < 2 || arg[0] != '@')
+        {
+            expanded.push_back(arg);
+            return;
+        }
+        if (depth == limits.max_include_depth)
+        {
+            throw limit_exceeded(limit_exceeded::limit::include_depth, limits.max_include_depth);
+        }
+
+        auto path = std::filesystem::weakly_canonical(std::filesystem::path(arg.substr(1)));
+        if (std::find(including.begin(), including.end(), path) != including.end())
+        {
+            throw std::runtime_error(detail::concat({ "response file '", path.string(), "' includes itself" }));
+        }
+
+        const auto& file = *files.emplace_back(std::make_unique<response_file>(path, threads));
+        including.push_back(std::move(path));
+        for (const auto token : file.get_tokens())
+        {
+            expand(token, expanded, depth + 1);
+        }
+        including.pop_back();
+    }
+}
@@ -0,0 +1,467 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// a command server: reads commands from a file descriptor, such as a
+// connected socket, parses them against a frozen schema on a pool of worker
+// threads and calls the handler registered for the first token of each
+//
+//     px::command_server server(schema);
+//     server.on("resize", [&](const px::parse_result& r) { resize(r.get(width)); });
+//     server.serve(fd);
+//
+// commands are separated by newlines or preceded by their length as four
+// bytes in network order. they are tokenized like presets, into views of
+// the read buffer, and each worker reuses its tokens and parse_result, whose
+// memory is kept between parses, so a command is not copied and, once the
+// worker has seen commands as large, parsing it does not allocate.
+// commands are handled concurrently, and so not necessarily in order; the
+// error handler is called for one command at a time
+// the parse_limits of the schema bound every command: one longer than
+// max_bytes is rejected while it is read, and tokenizing stops at max_tokens
+
+#pragma once
+
+#include "px_frozen.h"
+#include "px_preset.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+
+namespace px
+{
+    enum class framing { newline, length_prefixed };
+
+    class command_server
+    {
+    public:
+        using handler = std::function<void(const parse_result&)>;
+        using error_handler = std::function<void(std::string_view command, std::exception_ptr)>;
+
+        explicit command_server(const frozen_schema&,
+            std::size_t workers = std::max(1u, std::thread::hardware_concurrency()));
+        command_server(const command_server&) = delete;
+        command_server& operator=(const command_server&) = delete;
+        ~command_server();
+
+        // handlers are registered before serving
+        void on(std::string_view command, handler);
+        // called for unknown commands, commands that do not parse and
+        // handlers that throw, never concurrently; without one, serve
+        // rethrows the first error
+        void on_error(error_handler);
+
+        // reads commands until end of file, and returns when all are
+        // handled; when reading fails, it throws once those read are handled
+        void serve(int fd, framing = framing::newline);
+
+    private:
+        struct work
+        {
+            // keeps the buffer the command refers into alive
+            std::shared_ptr<const std::string> buffer;
+            std::string_view command;
+        };
+
+        void run();
+        void handle(std::string_view, std::vector<std::string_view>&, parse_result&);
+        void fail(std::string_view, std::exception_ptr);
+        void push(std::vector<work>&);
+
+        const frozen_schema& schema;
+        std::map<std::string, handler, std::less<>> handlers;
+        error_handler errors;
+        // serializes the calls of the error handler
+        std::mutex errors_mutex;
+        std::exception_ptr first_error;
+
+        std::mutex queue_mutex;
+        std::condition_variable queued;
+        std::condition_variable drained;
+        std::deque<work> queue;
+        std::size_t pending = 0;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+    };
+
+    // writes commands to a file descriptor in the framing of a server; a
+    // stand-in for clients in tests and benchmarks
+    class command_client
+    {
+    public:
+        explicit command_client(int fd, framing = framing::newline);
+
+        void send(std::string_view command);
+
+    private:
+        void write(std::string_view);
+
+        int fd;
+        framing frame;
+    };
+}
+
+namespace detail
+{
+    inline std::uint32_t read_length_prefix(const char* p)
+    {
+        const auto byte = [p](int i) { return static_cast<std::uint32_t>(static_cast<unsigned char>(p[i])); };
+        return (byte(0) << 24) | (byte(1) << 16) | (byte(2) << 8) | byte(3);
+    }
+}
+
+namespace px
+{
+    inline command_server::command_server(const frozen_schema& s, std::size_t n) :
+        schema(s)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            workers.emplace_back(&command_server::run, this);
+        }
+    }
+
+    inline command_server::~command_server()
+    {
+        {
+            std::lock_guard lock(queue_mutex);
+            stopping = true;
+        }
+        queued.notify_all();
+        for (auto& w : workers)
+        {
+            w.join();
+        }
+    }
+
+    inline void command_server::on(std::string_view command, handler h)
+    {
+        handlers.insert_or_assign(std::string(command), std::move(h));
+    }
+
+    inline void command_server::on_error(error_handler h)
+    {
+        errors = std::move(h);
+    }
+
+    inline void command_server::serve(int fd, framing frame)
+    {
+        constexpr std::size_t block_size = 64 * 1024;
+        auto buffer = std::make_shared<std::string>(block_size, '\0');
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        std::vector<work> batch;
+        std::exception_ptr read_error;
+
+        // a command longer than the byte limit is rejected as soon as that
+        // is known, and the rest of it is skipped without being buffered
+        const auto max_bytes = schema.get_limits().max_bytes;
+        std::size_t skip = 0;
+        auto skip_line = false;
+        // the bytes after begin known to hold no newline, so that a long
+        // command arriving in small reads is scanned once
+        std::size_t scanned = 0;
+        const auto reject = [&](std::string_view start)
+        {
+            fail(start, std::make_exception_ptr(limit_exceeded(limit_exceeded::limit::bytes, max_bytes)));
+        };
+
+        // splits the complete commands off the front of the buffer
+        const auto split = [&]()
+        {
+            while (begin < end)
+            {
+                const std::string_view available(buffer->data() + begin, end - begin);
+                if (skip > 0)
+                {
+                    const auto n = std::min(skip, available.size());
+                    begin += n;
+                    skip -= n;
+                }
+                else if (frame == framing::newline)
+                {
+                    const auto newline = available.find('\n', scanned);
+                    scanned = 0;
+                    if (skip_line)
+                    {
+                        skip_line = (newline == std::string_view::npos);
+                        begin += skip_line ? available.size() : newline + 1;
+                    }
+                    else if (newline == std::string_view::npos)
+                    {
+                        if (available.size() > max_bytes)
+                        {
+                            reject(available);
+                            skip_line = true;
+                            begin = end;
+                        }
+                        else
+                        {
+                            scanned = available.size();
+                        }
+                        break;
+                    }
+                    else
+                    {
+                        if (newline > max_bytes)
+                        {
+                            reject(available.substr(0, newline));
+                        }
+                        else
+                        {
+                            batch.push_back({ buffer, available.substr(0, newline) });
+                        }
+                        begin += newline + 1;
+                    }
+                }
+                else
+                {
+                    if (available.size() < 4)
+                    {
+                        break;
+                    }
+                    const auto length = detail::read_length_prefix(available.data());
+                    if (length > max_bytes)
+                    {
+                        reject(available.substr(4));
+                        skip = length;
+                        begin += 4;
+                    }
+                    else if (available.size() - 4 < length)
+                    {
+                        break;
+                    }
+                    else
+                    {
+                        batch.push_back({ buffer, available.substr(4, length) });
+                        begin += 4 + length;
+                    }
+                }
+            }
+        };
+
+        while (true)
+        {
+            if (end == buffer->size())
+            {
+                // a fresh buffer, as workers may still refer into this one; the
+                // incomplete command at its end is the only data copied
+                const auto rest = end - begin;
+                auto next = std::make_shared<std::string>(std::max(block_size, rest * 2), '\0');
+                next->replace(0, rest, *buffer, begin, rest);
+                buffer = std::move(next);
+                begin = 0;
+                end = rest;
+            }
+
+            const auto n = ::read(fd, buffer->data() + end, buffer->size() - end);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                // the commands already queued refer into the buffers, so
+                // they are handled before this is thrown
+                read_error = std::make_exception_ptr(
+                    std::system_error(errno, std::generic_category(), "reading commands"));
+                break;
+            }
+            else if (n == 0)
+            {
+                break;
+            }
+            end += static_cast<std::size_t>(n);
+            split();
+            push(batch);
+        }
+
+        if (!read_error && begin < end && !skip_line)
+        {
+            if (frame == framing::newline)
+            {
+                batch.push_back({ buffer, std::string_view(buffer->data() + begin, end - begin) });
+                push(batch);
+            }
+            else
+            {
+                fail(std::string_view(buffer->data() + begin, end - begin),
+                    std::make_exception_ptr(std::runtime_error("command truncated at end of input")));
+            }
+        }
+
+        std::unique_lock lock(queue_mutex);
+        drained.wait(lock, [this] { return pending == 0; });
+        const auto e = std::exchange(first_error, nullptr);
+        if (read_error)
+        {
+            std::rethrow_exception(read_error);
+        }
+        if (e)
+        {
+            std::rethrow_exception(e);
+        }
+    }
+
+    inline void command_server::push(std::vector<work>& batch)
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+        {
+            std::lock_guard lock(queue_mutex);
+            queue.insert(queue.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+            pending += batch.size();
+        }
+        if (batch.size() == 1)
+        {
+            queued.notify_one();
+        }
+        else
+        {
+            queued.notify_all();
+        }
+        batch.clear();
+    }
+
+    inline void command_server::run()
+    {
+        // reused for every command this worker handles
+        std::vector<std::string_view> tokens;
+        parse_result result;
+
+        while (true)
+        {
+            work w;
+            {
+                std::unique_lock lock(queue_mutex);
+                queued.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty())
+                {
+                    return;
+                }
+                w = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            handle(w.command, tokens, result);
+            w.buffer.reset();
+
+            std::lock_guard lock(queue_mutex);
+            if (--pending == 0)
+            {
+                drained.notify_all();
+            }
+        }
+    }
+
+    inline void command_server::handle(std::string_view command,
+        std::vector<std::string_view>& tokens, parse_result& result)
+    {
+        try
+        {
+            tokens.clear();
+            const auto max_tokens = schema.get_limits().max_tokens;
+            if (!detail::tokenize_preset(command, tokens,
+                (max_tokens == parse_limits::unlimited) ? max_tokens : max_tokens + 1))
+            {
+                throw limit_exceeded(limit_exceeded::limit::tokens, max_tokens);
+            }
+            if (tokens.empty())
+            {
+                return;
+            }
+
+            const auto h = handlers.find(tokens.front());
+            if (h == handlers.end())
+            {
+                throw std::runtime_error(detail::concat({ "unknown command '", tokens.front(), "'" }));
+            }
+            schema.parse(tokens, result);
+            h->second(result);
+        }
+        catch (...)
+        {
+            fail(command, std::current_exception());
+        }
+    }
+
+    inline void command_server::fail(std::string_view command, std::exception_ptr e)
+    {
+        if (errors)
+        {
+            std::lock_guard lock(errors_mutex);
+            errors(command, e);
+            return;
+        }
+        std::lock_guard lock(queue_mutex);
+        if (!first_error)
+        {
+            first_error = e;
+        }
+    }
+
+    inline command_client::command_client(int f, framing fr) :
+        fd(f),
+        frame(fr)
+    {
+    }
+
+    inline void command_client::send(std::string_view command)
+    {
+        if (frame == framing::newline)
+        {
+            if (command.find('\n') != std::string_view::npos)
+            {
+                throw std::logic_error("a newline framed command cannot contain a newline");
+            }
+            write(detail::concat({ command, "\n" }));
+        }
+        else
+        {
+            const auto n = static_cast<std::uint32_t>(command.size());
+            const char length[4] = { static_cast<char>(n >> 24), static_cast<char>(n >> 16),
+                static_cast<char>(n >> 8), static_cast<char>(n) };
+            write(detail::concat({ std::string_view(length, 4), command }));
+        }
+    }
+
+    inline void command_client::write(std::string_view text)
+    {
+        while (!text.empty())
+        {
+            const auto written = ::write(fd, text.data(), text.size());
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "writing command");
+            }
+            text.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// the tokenizer shared by presets, server commands and response files
+
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace detail
+{
+    // deliberately not constexpr: reaching it in constant evaluation is what
+    // makes a preset with an unterminated quote fail to compile
+    [[noreturn]] inline void preset_unterminated_quote(std::string_view s)
+    {
+        throw std::runtime_error("unterminated quote in '" + std::string(s) + "'");
+    }
+
+    constexpr bool is_preset_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // splits on white space; a token may be quoted with ' or " as a whole, in
+    // which case it is returned without the quotes. the tokens are appended,
+    // so that a vector can be reused; returns false, and stops, when there
+    // are more than max_tokens in the vector
+    constexpr bool tokenize_preset(std::string_view s, std::vector<std::string_view>& tokens,
+        std::size_t max_tokens = std::numeric_limits<std::size_t>::max())
+    {
+        std::size_t i = 0;
+        while (i < s.size())
+        {
+            if (tokens.size() == max_tokens && !is_preset_space(s[i]))
+            {
+                return false;
+            }
+            if (is_preset_space(s[i]))
+            {
+                ++i;
+            }
+            else if (s[i] == '\'' || s[i] == '"')
+            {
+                const auto close = s.find(s[i], i + 1);
+                if (close == std::string_view::npos)
+                {
+                    preset_unterminated_quote(s.substr(i));
+                }
+                tokens.push_back(s.substr(i + 1, close - i - 1));
+                i = close + 1;
+            }
+            else
+            {
+                auto j = i;
+                while (j < s.size() && !is_preset_space(s[j]))
+                {
+                    ++j;
+                }
+                tokens.push_back(s.substr(i, j - i));
+                i = j;
+            }
+        }
+        return true;
+    }
+
+    constexpr std::vector<std::string_view> tokenize_preset(std::string_view s)
+    {
+        std::vector<std::string_view> tokens;
+        tokenize_preset(s, tokens);
+        return tokens;
+    }
+}
@@ -0,0 +1,921 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// validators to pass to set_validator
+//
+//     px::memoized<std::filesystem::path> exists([](const auto& p) { return std::filesystem::exists(p); });
+//     cli.add_multi_value_argument<std::filesystem::path>("inputs", "-i")
+//         .set_validator(exists);
+//
+// memoized checks the elements of a multi value one by one, and each
+// distinct value only once. a pattern is compiled once into a table
+// driven automaton, and says what it matches in the help. a
+// validation_cache keeps the outcomes of checks of files across runs, in
+// a file mapped by every process using it
+//
+//     px::validation_cache cache(px::validation_cache::default_path("tool"));
+//     px::memoized<std::filesystem::path> readable(cache.wrap("readable", is_readable));
+
+#pragma once
+
+#include "px.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#ifdef PX_HAS_MMAP
+#include <sys/file.h>
+#endif
+
+namespace detail
+{
+    struct pattern_automaton;
+}
+
+namespace px
+{
+    struct memo_statistics
+    {
+        // the values validated, and how many of those were validated before
+        std::size_t checks = 0;
+        std::size_t hits = 0;
+
+        double hit_rate() const;
+    };
+
+    // a validator remembering the outcome of a check for each value; copies
+    // share the memo, which is emptied when it holds capacity values, and
+    // may be called concurrently
+    template <typename T>
+    class memoized
+    {
+    public:
+        using check_function = std::function<bool(const T&)>;
+
+        explicit memoized(check_function, std::size_t capacity = 4096);
+
+        bool operator()(const T&) const;
+        // whether every element passes
+        bool operator()(const std::vector<T>&) const;
+
+        memo_statistics get_statistics() const;
+
+    private:
+        struct hash
+        {
+            std::size_t operator()(const T&) const;
+        };
+
+        struct memo
+        {
+            check_function check;
+            std::size_t capacity;
+            std::mutex mutex;
+            std::unordered_map<T, bool, hash> outcomes;
+            memo_statistics statistics;
+        };
+
+        std::shared_ptr<memo> state;
+    };
+
+    // a restricted regular expression matching whole values: characters,
+    // ., [a-z], [^a-z], \d, \w and \s, \ before any other character for that
+    // character, *, +, ?, | and (); matching allocates nothing
+    class pattern
+    {
+    public:
+        explicit pattern(std::string_view expression);
+        // a shell pattern: * and ? for any characters, [a-z] and [!a-z]
+        static pattern glob(std::string_view);
+
+        bool matches(std::string_view) const;
+        // for strings, paths and vectors of these, whether every element matches
+        template <typename T>
+        bool operator()(const T&) const;
+
+        const std::string& get_expression() const;
+        std::string describe() const;
+
+    private:
+        std::string expression;
+        std::shared_ptr<const detail::pattern_automaton> automaton;
+    };
+
+    // outcomes of checks of files, shared between runs and processes, for a
+    // file as long as its device, inode, modification and change times are
+    // the same. without memory mapping, or when the cache file cannot be
+    // used, checks are run every time
+    class validation_cache
+    {
+    public:
+        using check_function = std::function<bool(const std::filesystem::path&)>;
+
+        explicit validation_cache(const std::filesystem::path& file, std::size_t slots = 1 << 14);
+
+        // px/name in $XDG_CACHE_HOME, or else in ~/.cache
+        static std::filesystem::path default_path(std::string_view name);
+
+        // a validator looking up the outcome of check, which name identifies
+        // in the cache; it keeps the cache mapped
+        check_function wrap(std::string_view name, check_function check) const;
+
+        bool is_mapped() const;
+        memo_statistics get_statistics() const;
+
+    private:
+        struct table;
+        std::shared_ptr<table> state;
+    };
+}
+
+namespace px
+{
+    inline double memo_statistics::hit_rate() const
+    {
+        return (checks == 0) ? 0.0 : static_cast<double>(hits) / static_cast<double>(checks);
+    }
+
+    template <typename T>
+    std::size_t memoized<T>::hash::operator()(const T& t) const
+    {
+        // std::filesystem::path has hash_value, but not always std::hash
+        if constexpr (requires { std::hash<T>{}(t); })
+        {
+            return std::hash<T>{}(t);
+        }
+        else
+        {
+            return hash_value(t);
+        }
+    }
+
+    template <typename T>
+    memoized<T>::memoized(check_function check, std::size_t capacity) :
+        state(std::make_shared<memo>())
+    {
+        state->check = std::move(check);
+        state->capacity = std::max<std::size_t>(1, capacity);
+    }
+
+    template <typename T>
+    bool memoized<T>::operator()(const T& t) const
+    {
+        {
+            std::lock_guard lock(state->mutex);
+            ++state->statistics.checks;
+            if (const auto i = state->outcomes.find(t); i != state->outcomes.end())
+            {
+                ++state->statistics.hits;
+                return i->second;
+            }
+        }
+
+        // checked without holding the lock, so a value checked concurrently
+        // by two threads may be checked twice
+        const auto valid = state->check(t);
+
+        std::lock_guard lock(state->mutex);
+        if (state->outcomes.size() == state->capacity)
+        {
+            state->outcomes.clear();
+        }
+        state->outcomes.emplace(t, valid);
+        return valid;
+    }
+
+    template <typename T>
+    bool memoized<T>::operator()(const std::vector<T>& values) const
+    {
+        return std::all_of(values.begin(), values.end(), [this](const T& t) { return (*this)(t); });
+    }
+
+    template <typename T>
+    memo_statistics memoized<T>::get_statistics() const
+    {
+        std::lock_guard lock(state->mutex);
+        return state->statistics;
+    }
+}
+
+namespace detail
+{
+    // a slot is written by one process at a time, which makes its sequence
+    // odd while writing; readers retry nothing, and take a slot written to
+    // while they read it as a miss
+    struct validation_cache_slot
+    {
+        std::uint32_t sequence;
+        std::uint32_t outcome;
+        std::uint64_t key;
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::uint64_t modified;
+        std::uint64_t changed;
+    };
+
+    struct file_identity
+    {
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        // in nanoseconds
+        std::uint64_t modified = 0;
+        std::uint64_t changed = 0;
+    };
+
+    inline std::uint64_t fnv1a(std::string_view s, std::uint64_t h = 14695981039346656037ull)
+    {
+        for (const auto c : s)
+        {
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return h;
+    }
+
+#ifdef PX_HAS_MMAP
+    inline bool identify(const std::filesystem::path& path, file_identity& id)
+    {
+        struct stat s;
+        if (::stat(path.c_str(), &s) != 0)
+        {
+            return false;
+        }
+        const auto nanoseconds = [](const timespec& t) { return static_cast<std::uint64_t>(t.tv_sec) * 1000000000 + static_cast<std::uint64_t>(t.tv_nsec); };
+        id = { static_cast<std::uint64_t>(s.st_dev), static_cast<std::uint64_t>(s.st_ino),
+            nanoseconds(s.st_mtim), nanoseconds(s.st_ctim) };
+        return true;
+    }
+#endif
+}
+
+namespace px
+{
+    struct validation_cache::table
+    {
+        static constexpr std::uint64_t magic = 0x3130636469767870ull;
+        static constexpr std::size_t probes = 8;
+
+        ~table()
+        {
+#ifdef PX_HAS_MMAP
+            if (mapping != nullptr)
+            {
+                ::munmap(mapping, size);
+            }
+#endif
+        }
+
+        void* mapping = nullptr;
+        std::size_t size = 0;
+        detail::validation_cache_slot* slots = nullptr;
+        std::size_t slot_count = 0;
+        std::atomic<std::size_t> checks{ 0 };
+        std::atomic<std::size_t> hits{ 0 };
+    };
+
+    inline validation_cache::validation_cache(const std::filesystem::path& file, std::size_t slot_count) :
+        state(std::make_shared<table>())
+    {
+#ifdef PX_HAS_MMAP
+        static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free && std::atomic_ref<std::uint32_t>::is_always_lock_free,
+            "the cache is shared between processes through lock free atomics");
+
+        std::error_code error;
+        std::filesystem::create_directories(file.parent_path(), error);
+        const auto fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        // the first process sizes the file, and the others use its size; the
+        // lock keeps two from sizing it differently, which would leave the
+        // one that mapped more faulting past the end of the file
+        struct stat s{};
+        constexpr auto header_size = sizeof(std::uint64_t) * 2;
+        const auto wanted = header_size + std::max<std::size_t>(table::probes, slot_count) * sizeof(detail::validation_cache_slot);
+        while (::flock(fd, LOCK_EX) != 0 && errno == EINTR)
+        {
+        }
+        if (::fstat(fd, &s) == 0 && s.st_size == 0 && ::ftruncate(fd, static_cast<off_t>(wanted)) == 0)
+        {
+            ::fstat(fd, &s);
+        }
+        // a file too small to be a cache is of another format
+        if (s.st_size >= static_cast<off_t>(header_size + table::probes * sizeof(detail::validation_cache_slot)))
+        {
+            const auto size = static_cast<std::size_t>(s.st_size);
+            auto* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                state->mapping = mapping;
+                state->size = size;
+
+                // a file of another format is left alone
+                std::atomic_ref<std::uint64_t> header(*static_cast<std::uint64_t*>(mapping));
+                auto expected = std::uint64_t{ 0 };
+                header.compare_exchange_strong(expected, table::magic);
+                const auto count = (size - header_size) / sizeof(detail::validation_cache_slot);
+                if (expected == 0 || expected == table::magic)
+                {
+                    state->slots = reinterpret_cast<detail::validation_cache_slot*>(static_cast<std::uint64_t*>(mapping) + 2);
+                    state->slot_count = count;
+                }
+            }
+        }
+        ::close(fd);
+#else
+        static_cast<void>(file);
+        static_cast<void>(slot_count);
+#endif
+    }
+
+    inline std::filesystem::path validation_cache::default_path(std::string_view name)
+    {
+        std::filesystem::path directory;
+        if (const auto* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0')
+        {
+            directory = xdg;
+        }
+        else if (const auto* home = std::getenv("HOME"); home != nullptr)
+        {
+            directory = std::filesystem::path(home) / ".cache";
+        }
+        else
+        {
+            directory = std::filesystem::temp_directory_path();
+        }
+        return directory / "px" / name;
+    }
+
+    inline bool validation_cache::is_mapped() const
+    {
+        return state->slots != nullptr;
+    }
+
+    inline memo_statistics validation_cache::get_statistics() const
+    {
+        return { state->checks.load(std::memory_order_relaxed), state->hits.load(std::memory_order_relaxed) };
+    }
+
+    inline validation_cache::check_function validation_cache::wrap(std::string_view name, check_function check) const
+    {
+        return [t = state, seed = detail::fnv1a(name), check = std::move(check)](const std::filesystem::path& path)
+        {
+            t->checks.fetch_add(1, std::memory_order_relaxed);
+#ifdef PX_HAS_MMAP
+            detail::file_identity id;
+            if (t->slots == nullptr || !detail::identify(path, id))
+            {
+                return check(path);
+            }
+
+            // keyed by check and path, and valid for the identity of the file
+            const auto key = detail::fnv1a(path.native(), seed) | 1;
+            const auto first = static_cast<std::size_t>(key % t->slot_count);
+            auto* slots = t->slots;
+            const auto slot_at = [&](std::size_t i) -> detail::validation_cache_slot& { return slots[(first + i) % t->slot_count]; };
+            const auto load64 = [](std::uint64_t& v) { return std::atomic_ref<std::uint64_t>(v).load(std::memory_order_relaxed); };
+
+            for (std::size_t i = 0; i < table::probes; ++i)
+            {
+                auto& slot = slot_at(i);
+                std::atomic_ref<std::uint32_t> sequence(slot.sequence);
+                const auto before = sequence.load(std::memory_order_acquire);
+                if (before % 2 != 0 || load64(slot.key) != key)
+                {
+                    continue;
+                }
+                const auto matches = load64(slot.device) == id.device && load64(slot.inode) == id.inode &&
+                    load64(slot.modified) == id.modified && load64(slot.changed) == id.changed;
+                const auto outcome = std::atomic_ref<std::uint32_t>(slot.outcome).load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (matches && sequence.load(std::memory_order_relaxed) == before)
+                {
+                    t->hits.fetch_add(1, std::memory_order_relaxed);
+                    return outcome != 0;
+                }
+                break;
+            }
+
+            const auto valid = check(path);
+
+            // recorded in the slot of the key, or in the first free slot, or
+            // else in the first slot; a slot being written is skipped
+            auto* target = &slot_at(0);
+            for (std::size_t i = 0; i < table::probes; ++i)
+            {
+                const auto k = load64(slot_at(i).key);
+                if (k == key || k == 0)
+                {
+                    target = &slot_at(i);
+                    break;
+                }
+            }
+            std::atomic_ref<std::uint32_t> sequence(target->sequence);
+            auto before = sequence.load(std::memory_order_relaxed);
+            if (before % 2 == 0 && sequence.compare_exchange_strong(before, before + 1, std::memory_order_acquire))
+            {
+                std::atomic_thread_fence(std::memory_order_release);
+                const auto store64 = [](std::uint64_t& v, std::uint64_t x) { std::atomic_ref<std::uint64_t>(v).store(x, std::memory_order_relaxed); };
+                store64(target->key, key);
+                store64(target->device, id.device);
+                store64(target->inode, id.inode);
+                store64(target->modified, id.modified);
+                store64(target->changed, id.changed);
+                std::atomic_ref<std::uint32_t>(target->outcome).store(valid ? 1 : 0, std::memory_order_relaxed);
+                sequence.store(before + 2, std::memory_order_release);
+            }
+            return valid;
+#else
+            return check(path);
+#endif
+        };
+    }
+}
+
+namespace detail
+{
+    // states by bytes, where bytes that no part of the expression tells
+    // apart share a class; state 0 accepts nothing and never leaves
+    struct pattern_automaton
+    {
+        std::array<std::uint8_t, 256> classes{};
+        std::size_t class_count = 1;
+        std::vector<std::uint16_t> next;
+        std::vector<std::uint8_t> accepting;
+        std::uint16_t start = 0;
+    };
+
+    // parses into a nondeterministic automaton of single byte sets and
+    // empty transitions, and builds the deterministic one from its subsets
+    class pattern_compiler
+    {
+    public:
+        static constexpr std::size_t max_states = 4096;
+
+        explicit pattern_compiler(std::string_view e) :
+            expression(e)
+        {
+        }
+
+        pattern_automaton compile()
+        {
+            const auto whole = alternation();
+            if (i < expression.size())
+            {
+                fail("unbalanced parenthesis");
+            }
+            return determinize(whole);
+        }
+
+    private:
+        using byte_set = std::bitset<256>;
+
+        struct state
+        {
+            byte_set on;
+            int next = -1;
+            std::vector<int> empty;
+        };
+
+        struct fragment
+        {
+            int start;
+            int end;
+        };
+
+        [[noreturn]] void fail(std::string_view what) const
+        {
+            throw std::logic_error(concat({ what, " at ", std::to_string(i), " in pattern '", expression, "'" }));
+        }
+
+        int add()
+        {
+            states.emplace_back();
+            return static_cast<int>(states.size() - 1);
+        }
+
+        void link(int from, int to)
+        {
+            states[static_cast<std::size_t>(from)].empty.push_back(to);
+        }
+
+        fragment of(const byte_set& set)
+        {
+            const auto s = add();
+            const auto e = add();
+            states[static_cast<std::size_t>(s)].on = set;
+            states[static_cast<std::size_t>(s)].next = e;
+            return { s, e };
+        }
+
+        fragment alternation()
+        {
+            auto f = sequence();
+            while (i < expression.size() && expression[i] == '|')
+            {
+                ++i;
+                const auto g = sequence();
+                const auto s = add();
+                const auto e = add();
+                link(s, f.start);
+                link(s, g.start);
+                link(f.end, e);
+                link(g.end, e);
+                f = { s, e };
+            }
+            return f;
+        }
+
+        fragment sequence()
+        {
+            const auto s = add();
+            fragment f{ s, s };
+            while (i < expression.size() && expression[i] != '|' && expression[i] != ')')
+            {
+                const auto g = repetition();
+                link(f.end, g.start);
+                f.end = g.end;
+            }
+            return f;
+        }
+
+        fragment repetition()
+        {
+            auto f = atom();
+            while (i < expression.size() && (expression[i] == '*' || expression[i] == '+' || expression[i] == '?'))
+            {
+                const auto c = expression[i++];
+                const auto e = add();
+                link(f.end, e);
+                if (c != '?')
+                {
+                    link(f.end, f.start);
+                }
+                if (c != '+')
+                {
+                    const auto s = add();
+                    link(s, f.start);
+                    link(s, e);
+                    f.start = s;
+                }
+                f.end = e;
+            }
+            return f;
+        }
+
+        fragment atom()
+        {
+            const auto c = expression[i];
+            if (c == '(')
+            {
+                ++i;
+                const auto f = alternation();
+                if (i == expression.size() || expression[i] != ')')
+                {
+                    fail("unbalanced parenthesis");
+                }
+                ++i;
+                return f;
+            }
+            if (c == '*' || c == '+' || c == '?')
+            {
+                fail("nothing to repeat");
+            }
+            byte_set set;
+            if (c == '.')
+            {
+                set.set();
+                ++i;
+            }
+            else if (c == '[')
+            {
+                set = bracket();
+            }
+            else if (c == '\\')
+            {
+                set = escape();
+            }
+            else
+            {
+                set.set(static_cast<unsigned char>(c));
+                ++i;
+            }
+            return of(set);
+        }
+
+        // at a backslash
+        byte_set escape()
+        {
+            if (++i == expression.size())
+            {
+                fail("trailing backslash");
+            }
+            byte_set set;
+            const auto range = [&set](unsigned char low, unsigned char high)
+            {
+                for (auto b = low; b <= high; ++b)
+                {
+                    set.set(b);
+                }
+            };
+            switch (const auto c = expression[i++])
+            {
+            case 'd':
+                range('0', '9');
+                break;
+            case 'w':
+                range('0', '9');
+                range('a', 'z');
+                range('A', 'Z');
+                set.set('_');
+                break;
+            case 's':
+                for (const auto space : { ' ', '\t', '\n', '\r', '\f', '\v' })
+                {
+                    set.set(static_cast<unsigned char>(space));
+                }
+                break;
+            default:
+                set.set(static_cast<unsigned char>(c));
+            }
+            return set;
+        }
+
+        // at an opening bracket
+        byte_set bracket()
+        {
+            ++i;
+            const auto negate = i < expression.size() && expression[i] == '^';
+            if (negate)
+            {
+                ++i;
+            }
+            byte_set set;
+            for (auto first = true; ; first = false)
+            {
+                if (i == expression.size())
+                {
+                    fail("unterminated set");
+                }
+                if (expression[i] == ']' && !first)
+                {
+                    ++i;
+                    break;
+                }
+                if (expression[i] == '\\')
+                {
+                    const auto escaped = escape();
+                    set |= escaped;
+                    if (escaped.count() > 1)
+                    {
+                        continue;
+                    }
+                    --i;
+                }
+                const auto low = static_cast<unsigned char>(expression[i++]);
+                auto high = low;
+                if (i + 1 < expression.size() && expression[i] == '-' && expression[i + 1] != ']')
+                {
+                    ++i;
+                    if (expression[i] == '\\')
+                    {
+                        ++i;
+                        if (i == expression.size())
+                        {
+                            fail("trailing backslash");
+                        }
+                    }
+                    high = static_cast<unsigned char>(expression[i++]);
+                    if (high < low)
+                    {
+                        fail("reversed range");
+                    }
+                }
+                for (auto b = static_cast<unsigned>(low); b <= high; ++b)
+                {
+                    set.set(b);
+                }
+            }
+            return negate ? ~set : set;
+        }
+
+        std::vector<int> closure(std::vector<int> from) const
+        {
+            std::vector<bool> seen(states.size());
+            std::vector<int> result;
+            while (!from.empty())
+            {
+                const auto s = from.back();
+                from.pop_back();
+                if (seen[static_cast<std::size_t>(s)])
+                {
+                    continue;
+                }
+                seen[static_cast<std::size_t>(s)] = true;
+                result.push_back(s);
+                const auto& empty = states[static_cast<std::size_t>(s)].empty;
+                from.insert(from.end(), empty.begin(), empty.end());
+            }
+            std::sort(result.begin(), result.end());
+            return result;
+        }
+
+        pattern_automaton determinize(const fragment& whole)
+        {
+            pattern_automaton a;
+
+            // each set splits the classes into bytes in it and bytes not
+            for (const auto& s : states)
+            {
+                if (s.next < 0)
+                {
+                    continue;
+                }
+                std::vector<int> split(a.class_count * 2, -1);
+                std::size_t count = 0;
+                for (std::size_t b = 0; b < 256; ++b)
+                {
+                    auto& c = split[a.classes[b] * 2 + (s.on[b] ? 1 : 0)];
+                    if (c < 0)
+                    {
+                        c = static_cast<int>(count++);
+                    }
+                    a.classes[b] = static_cast<std::uint8_t>(c);
+                }
+                a.class_count = count;
+            }
+            std::vector<std::size_t> representative(a.class_count);
+            for (std::size_t b = 256; b-- > 0;)
+            {
+                representative[a.classes[b]] = b;
+            }
+
+            std::map<std::vector<int>, std::uint16_t> ids{ { {}, 0 } };
+            std::vector<const std::vector<int>*> subsets{ &ids.begin()->first };
+            const auto id_of = [&](std::vector<int> subset)
+            {
+                const auto [i, added] = ids.emplace(std::move(subset), static_cast<std::uint16_t>(ids.size()));
+                if (added)
+                {
+                    if (ids.size() > max_states)
+                    {
+                        fail("too many states");
+                    }
+                    subsets.push_back(&i->first);
+                }
+                return i->second;
+            };
+            a.start = id_of(closure({ whole.start }));
+
+            for (std::size_t d = 0; d < subsets.size(); ++d)
+            {
+                a.accepting.push_back(std::binary_search(subsets[d]->begin(), subsets[d]->end(), whole.end) ? 1 : 0);
+                for (std::size_t k = 0; k < a.class_count; ++k)
+                {
+                    std::vector<int> moved;
+                    for (const auto s : *subsets[d])
+                    {
+                        const auto& st = states[static_cast<std::size_t>(s)];
+                        if (st.next >= 0 && st.on[representative[k]])
+                        {
+                            moved.push_back(st.next);
+                        }
+                    }
+                    const auto next = moved.empty() ? std::uint16_t{ 0 } : id_of(closure(std::move(moved)));
+                    a.next.push_back(next);
+                }
+            }
+            return a;
+        }
+
+        std::string_view expression;
+        std::size_t i = 0;
+        std::vector<state> states;
+    };
+}
+
+namespace px
+{
+    inline pattern::pattern(std::string_view e) :
+        expression(e),
+        automaton(std::make_shared<const detail::pattern_automaton>(detail::pattern_compiler(e).compile()))
+    {
+    }
+
+    inline pattern pattern::glob(std::string_view g)
+    {
+        std::string e;
+        for (std::size_t i = 0; i < g.size(); ++i)
+        {
+            const auto c = g[i];
+            const auto close = (c == '[') ? g.find(']', i + ((i + 2 < g.size() && (g[i + 1] == '!' || g[i + 1] == '^')) ? 3 : 2)) : std::string_view::npos;
+            if (c == '*')
+            {
+                e += ".*";
+            }
+            else if (c == '?')
+            {
+                e += '.';
+            }
+            else if (close != std::string_view::npos)
+            {
+                e += '[';
+                auto j = i + 1;
+                if (g[j] == '!' || g[j] == '^')
+                {
+                    e += '^';
+                    ++j;
+                }
+                for (; j < close; ++j)
+                {
+                    if (g[j] == '\\')
+                    {
+                        e += '\\';
+                    }
+                    e += g[j];
+                }
+                e += ']';
+                i = close;
+            }
+            else
+            {
+                if (std::string_view(".[]()|*+?\\").find(c) != std::string_view::npos)
+                {
+                    e += '\\';
+                }
+                e += c;
+            }
+        }
+        pattern p(e);
+        p.expression = g;
+        return p;
+    }
+
+    inline bool pattern::matches(std::string_view value) const
+    {
+        const auto& a = *automaton;
+        auto s = a.start;
+        for (const auto c : value)
+        {
+            s = a.next[s * a.class_count + a.classes[static_cast<unsigned char>(c)]];
+            if (s == 0)
+            {
+                return false;
+            }
+        }
+        return a.accepting[s] != 0;
+    }
+
+    template <typename T>
+    bool pattern::operator()(const T& value) const
+    {
+        if constexpr (detail::is_vector<T>::value)
+        {
+            return std::all_of(value.begin(), value.end(), [this](const auto& v) { return (*this)(v); });
+        }
+        else if constexpr (requires { std::string_view(value.native()); })
+        {
+            return matches(value.native());
+        }
+        else if constexpr (requires { value.string(); })
+        {
+            return matches(value.string());
+        }
+        else
+        {
+            return matches(std::string_view(value));
+        }
+    }
+
+    inline const std::string& pattern::get_expression() const
+    {
+        return expression;
+    }
+
+    inline std::string pattern::describe() const
+    {
+        return detail::concat({ "matching '", expression, "'" });
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// the px module interface unit; `import px;` replaces `#include "px.h"`
+
+module;
+
+#include "px.h"
+
+export module px;
+
+export namespace px
+{
+    using px::scalar;
+    using px::multi_scalar;
+    using px::mapped_file;
+    using px::metadata_string;
+    using px::argv_iterator;
+    using px::name_key;
+    using px::help_sink;
+    using px::string_sink;
+    using px::file_sink;
+#if __has_include(<unistd.h>)
+    using px::fd_sink;
+#endif
+#ifndef PX_NO_IOSTREAM
+    using px::ostream_sink;
+#endif
+    using px::memory_bytes;
+    using px::memory_breakdown;
+    using px::iargument;
+    using px::argument_core;
+    using px::argument;
+    using px::positional_argument_core;
+    using px::tag_argument_core;
+    using px::positional_argument;
+    using px::tag_argument;
+    using px::dispatch_strategy;
+    using px::parse_limits;
+    using px::limit_exceeded;
+    using px::argv_array;
+#ifdef PX_TRACE
+    using px::parse_tracer;
+#endif
+    using px::command_line;
+
+    namespace literals
+    {
+        using px::literals::operator""_px;
+    }
+}
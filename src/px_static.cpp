@@ -0,0 +1,44 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// the single translation unit of px_static: the non-template parts of px and
+// the explicit instantiations for PX_COMMON_TYPES
+
+#include "px.h"
+
+#define PX_INSTANTIATION(T)                                                              \
+    template class px::scalar<T>;                                                        \
+    template class px::multi_scalar<T>;                                                  \
+    template class px::tag_argument<T>;                                                  \
+    template class px::tag_argument<T, px::multi_scalar<T>>;                             \
+    template class px::positional_argument<T>;                                           \
+    template px::tag_argument<T>&                                                        \
+        px::command_line::add_value_argument<T>(std::string_view, std::string_view);     \
+    template px::tag_argument<T, px::multi_scalar<T>>&                                   \
+        px::command_line::add_multi_value_argument<T>(std::string_view, std::string_view); \
+    template px::positional_argument<T>&                                                 \
+        px::command_line::add_positional_argument<T>(std::string_view);                  \
+    template const T& px::command_line::get<T>(std::string_view) const;                  \
+    template const T& px::command_line::get<T>(px::name_key) const;                      \
+    template const std::vector<T>& px::command_line::get<std::vector<T>>(std::string_view) const; \
+    template const std::vector<T>& px::command_line::get<std::vector<T>>(px::name_key) const;
+
+template class px::tag_argument<bool, px::scalar<bool>>;
+template const bool& px::command_line::get<bool>(std::string_view) const;
+template const bool& px::command_line::get<bool>(px::name_key) const;
+PX_COMMON_TYPES(PX_INSTANTIATION)
@@ -20,6 +20,8 @@
 
 #include <gtest/gtest.h>
 #include <filesystem>
+#include <fstream>
+#include <random>
 
 namespace
 {
@@ -102,6 +104,38 @@ namespace px_tests
         EXPECT_FALSE(flag);
     }
 
+    TEST_F(px_test, throws_on_exceeding_limits)
+    {
+        cli.add_value_argument<std::string>("name", "-n");
+        cli.add_multi_value_argument<int>("integers", "-i");
+        px::parse_limits limits;
+        limits.max_tokens = 6;
+        limits.max_bytes = 20;
+        limits.max_value_length = 8;
+        limits.max_values_per_argument = 3;
+        cli.set_limits(limits);
+
+        const auto exceeded = [this](const std::vector<std::string>& args)
+        {
+            try
+            {
+                cli.parse(args);
+            }
+            catch (const px::limit_exceeded& e)
+            {
+                return std::optional(e.which());
+            }
+            return std::optional<px::limit_exceeded::limit>();
+        };
+
+        using limit = px::limit_exceeded::limit;
+        EXPECT_EQ(std::nullopt, exceeded({ programName, "-n", "name", "-i", "1", "2", "3" }));
+        EXPECT_EQ(limit::tokens, exceeded({ programName, "-i", "1", "-i", "2", "-i", "3", "-n" }));
+        EXPECT_EQ(limit::value_length, exceeded({ programName, "-n", "too long a name" }));
+        EXPECT_EQ(limit::bytes, exceeded({ programName, "-n", "12345678", "-n", "12345678", "-n", "12345678" }));
+        EXPECT_EQ(limit::values_per_argument, exceeded({ programName, "-i", "1", "2", "3", "4" }));
+    }
+
     class px_positional_arg_test : public px_test
     {
     protected:
@@ -211,6 +245,66 @@ namespace px_tests
         EXPECT_FALSE(arg.is_valid());
     }
 
+    TEST_F(px_value_arg_test, throws_on_tag_without_value)
+    {
+        cli.add_value_argument<int>("some integer", "-i");
+
+        const std::vector<std::string> args = { programName, "-i" };
+        EXPECT_THROW(cli.parse(args), std::runtime_error);
+    }
+
+    TEST_F(px_value_arg_test, can_get_value_by_name)
+    {
+        using namespace px::literals;
+        cli.add_flag_argument("flag", "-f");
+        cli.add_value_argument<int>("some integer", "-i");
+        cli.add_multi_value_argument<int>("some integers", "--ints");
+        cli.add_positional_argument<std::string>("name");
+
+        const std::vector<std::string> args = { programName, "--ints", "1", "2", "-f", "-i", "3", "--", "jan" };
+        cli.parse(args);
+
+        EXPECT_TRUE(cli.get<bool>("flag"));
+        EXPECT_EQ(3, cli.get<int>("some integer"_px));
+        EXPECT_EQ(std::vector<int>({ 1, 2 }), cli.get<std::vector<int>>("some integers"));
+        EXPECT_EQ("jan", cli.get<std::string>("name"_px));
+    }
+
+    TEST_F(px_value_arg_test, can_get_value_by_name_from_many_arguments)
+    {
+        // kept alive for the views of PX_STATIC_METADATA
+        std::vector<std::string> names;
+        std::vector<std::string> tags;
+        for (auto i = 0; i < 1000; ++i)
+        {
+            names.push_back("option " + std::to_string(i));
+            tags.push_back("--opt" + std::to_string(i));
+        }
+        for (auto i = 0; i < 1000; ++i)
+        {
+            cli.add_value_argument<int>(names[i], tags[i]);
+        }
+
+        const std::vector<std::string> args = { programName, "--opt999", "999", "--opt0", "0" };
+        cli.parse(args);
+
+        constexpr px::name_key last("option 999");
+        EXPECT_EQ(999, cli.get<int>(last));
+        EXPECT_EQ(0, cli.get<int>("option 0"));
+    }
+
+    TEST_F(px_value_arg_test, throws_on_getting_value_by_unknown_name_or_wrong_type)
+    {
+        cli.add_value_argument<int>("some integer", "-i");
+
+        const std::vector<std::string> args = { programName, "-i", "3" };
+        cli.parse(args);
+
+        EXPECT_THROW(cli.get<int>("other integer"), std::logic_error);
+        EXPECT_THROW(cli.get<long>("some integer"), std::logic_error);
+        EXPECT_THROW(cli.get<std::vector<int>>("some integer"), std::logic_error);
+    }
+
     TEST_F(px_value_arg_test, can_parse_string_value_arg)
     {
         auto& arg = cli.add_value_argument<std::string>("some string", "-s")
@@ -223,6 +317,45 @@ namespace px_tests
         EXPECT_EQ(s, arg.get_value());
     }
 
+    TEST_F(px_value_arg_test, string_view_value_refers_into_arguments)
+    {
+        auto& arg = cli.add_value_argument<std::string_view>("some string", "-s");
+
+        const std::vector<std::string> args = { programName, "-s", "jannssen" };
+        cli.parse(args);
+
+        EXPECT_EQ("jannssen", arg.get_value());
+        EXPECT_EQ(args[2].data(), arg.get_value().data());
+    }
+
+    TEST_F(px_value_arg_test, can_map_value_from_file)
+    {
+        auto& payload = cli.add_value_argument<std::string_view>("payload", "-p")
+            .set_value_from_file(true);
+        auto& literal = cli.add_value_argument<std::string_view>("literal", "-l");
+
+        // testpx_static_metadata runs this file too, maybe at the same
+        // time, so the name is drawn per process
+        const auto path = std::filesystem::temp_directory_path() /
+            ("px_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + "_" +
+             std::to_string(std::random_device()()));
+        const std::string contents(100000, 'x');
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << contents;
+        }
+
+        const std::vector<std::string> args = { programName, "-p", "@" + path.string(), "-l", "@" + path.string() };
+        cli.parse(args);
+        std::filesystem::remove(path);
+
+        EXPECT_EQ(contents, payload.get_value());
+        EXPECT_EQ("@" + path.string(), literal.get_value());
+
+        const std::vector<std::string> missing = { programName, "-p", "@" + path.string() };
+        EXPECT_THROW(cli.parse(missing), std::runtime_error);
+    }
+
     TEST_F(px_value_arg_test, required_arg_without_value_is_invalid)
     {
         auto& arg = cli.add_value_argument<int>("some integer", "-i")
@@ -279,6 +412,49 @@ namespace px_tests
         EXPECT_THROW(cli.parse(args), std::runtime_error);
     }
 
+    TEST_F(px_value_arg_test, default_is_computed_only_without_value)
+    {
+        auto computed = 0;
+        auto bound = 0;
+        auto& arg = cli.add_value_argument<int>("threads", "-t")
+            .set_default([&computed] { ++computed; return 8; })
+            .bind(&bound);
+
+        cli.parse(std::vector<std::string>{ programName, "-t", "2" });
+        EXPECT_EQ(0, computed);
+        EXPECT_EQ(2, arg.get_value());
+
+        px::command_line other("other");
+        auto& defaulted = other.add_value_argument<int>("threads", "-t")
+            .set_default([&computed] { ++computed; return 8; })
+            .bind(&bound);
+        other.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(1, computed);
+        EXPECT_EQ(8, defaulted.get_value());
+        EXPECT_EQ(8, bound);
+    }
+
+    TEST_F(px_value_arg_test, default_is_validated_and_shown_in_help_when_printed)
+    {
+        auto computed = 0;
+        cli.add_value_argument<std::string>("model", "-m")
+            .set_description("the model")
+            .set_default([&computed] { ++computed; return std::string("small"); })
+            .set_validator([](const std::string& s) { return s != "small"; });
+        cli.add_multi_value_argument<double>("weights", "-w")
+            .set_default([] { return std::vector<double>{ 0.5, 2 }; });
+        EXPECT_EQ(0, computed);
+
+        std::string help;
+        px::string_sink sink(help);
+        cli.print_help(sink);
+        EXPECT_EQ(1, computed);
+        EXPECT_NE(std::string::npos, help.find("the model (default small)")) << help;
+        EXPECT_NE(std::string::npos, help.find("(default 0.5 2)")) << help;
+
+        EXPECT_THROW(cli.parse(std::vector<std::string>{ programName }), std::runtime_error);
+    }
+
     class px_flag_arg_test : public px_test
     {
     protected:
@@ -402,4 +578,278 @@ namespace px_tests
         arg.set_validator(all_less_than_5);
         EXPECT_TRUE(arg.is_valid());
     }
+
+    class px_to_argv_test : public px_test
+    {
+    protected:
+        void add_arguments(px::command_line& c)
+        {
+            c.add_value_argument<int>("count", "-n");
+            c.add_value_argument<std::string>("name", "--name");
+            c.add_multi_value_argument<double>("ratios", "-r");
+            c.add_flag_argument("verbose", "-v");
+            c.add_flag_argument("quiet", "-q");
+            c.add_positional_argument<std::string>("input");
+        }
+
+        std::vector<std::string> parse_args{ programName, "-n", "-12", "--name", "a name", "-r", "0.25", "1e+100", "-v", "--", "input" };
+    };
+
+    TEST_F(px_to_argv_test, child_parses_the_same_values)
+    {
+        add_arguments(cli);
+        cli.parse(parse_args);
+
+        const auto argv = cli.to_argv("child");
+        ASSERT_EQ(11u, argv.size());
+        EXPECT_EQ(nullptr, argv.get()[argv.size()]);
+        EXPECT_EQ("child", argv[0]);
+        EXPECT_EQ("--", argv[9]);
+        EXPECT_EQ("input", argv[10]);
+        EXPECT_TRUE(argv.get_response_file().empty());
+
+        px::command_line child("child");
+        add_arguments(child);
+        child.parse(static_cast<int>(argv.size()), const_cast<char**>(argv.get()));
+        EXPECT_EQ(-12, child.get<int>("count"));
+        EXPECT_EQ("a name", child.get<std::string>("name"));
+        EXPECT_EQ((std::vector<double>{ 0.25, 1e100 }), child.get<std::vector<double>>("ratios"));
+        EXPECT_TRUE(child.get<bool>("verbose"));
+        EXPECT_FALSE(child.get<bool>("quiet"));
+    }
+
+    TEST_F(px_to_argv_test, filter_selects_arguments_by_name)
+    {
+        add_arguments(cli);
+        cli.parse(parse_args);
+
+        const auto argv = cli.to_argv("child", [](std::string_view name) { return name == "count" || name == "quiet"; });
+        ASSERT_EQ(3u, argv.size());
+        EXPECT_EQ("-n", argv[1]);
+        EXPECT_EQ("-12", argv[2]);
+    }
+
+    class px_memory_usage_test : public px_test
+    {
+    protected:
+        px_memory_usage_test()
+        {
+            cli.add_value_argument<int>("count", "-n");
+            cli.add_multi_value_argument<std::string>("names", "--names")
+                .bind(&names);
+            cli.add_positional_argument<std::string>("input")
+                .set_description(description);
+        }
+
+        const std::string description = std::string(100, 'd');
+
+        std::vector<std::string> names;
+        const std::string long_name = std::string(40, 'x');
+    };
+
+    TEST_F(px_memory_usage_test, breaks_down_each_argument)
+    {
+        const auto before = cli.memory_usage();
+        ASSERT_EQ(3u, before.arguments.size());
+        EXPECT_EQ("count", before.arguments[0].name);
+        EXPECT_EQ("input", before.arguments[2].name);
+        EXPECT_EQ(0u, before.arguments[0].values.heap_bytes);
+        EXPECT_EQ(0u, before.arguments[0].bound.total());
+#ifdef PX_STATIC_METADATA
+        EXPECT_EQ(0u, before.arguments[2].metadata.heap_bytes);
+#else
+        EXPECT_LE(description.size() + 1, before.arguments[2].metadata.heap_bytes);
+#endif
+        EXPECT_LT(0u, before.arguments[0].callables.inline_bytes);
+
+        cli.parse(std::vector<std::string>{ programName, "--names", long_name, long_name, "-n", "3", "--", "in" });
+        const auto after = cli.memory_usage();
+        const auto& multi = after.arguments[1];
+        EXPECT_LE(2 * sizeof(std::string) + 2 * (long_name.size() + 1), multi.values.heap_bytes);
+        EXPECT_EQ(sizeof(std::vector<std::string>), multi.bound.inline_bytes);
+        EXPECT_LE(2 * sizeof(std::string) + 2 * (long_name.size() + 1), multi.bound.heap_bytes);
+        EXPECT_LE(multi.metadata.inline_bytes + multi.callables.inline_bytes + multi.values.inline_bytes, multi.object_bytes);
+        EXPECT_EQ(multi.object_bytes + multi.metadata.heap_bytes + multi.callables.heap_bytes + multi.values.heap_bytes +
+            multi.bound.total(), multi.total());
+    }
+
+    TEST_F(px_memory_usage_test, sums_categories_over_arguments)
+    {
+        const std::string args[] = { programName, "--names", long_name, "in" };
+        std::vector<char*> argv;
+        for (const auto& a : args)
+        {
+            argv.push_back(const_cast<char*>(a.c_str()));
+        }
+        const auto before = cli.memory_usage();
+        cli.parse(static_cast<int>(argv.size()), argv.data());
+        const auto usage = cli.memory_usage();
+
+        // the copy of argv
+        EXPECT_LE(before.schema.heap_bytes + argv.size() * sizeof(std::string) + long_name.size() + 1, usage.schema.heap_bytes);
+        px::memory_bytes values;
+        auto total = usage.schema.total();
+        for (const auto& a : usage.arguments)
+        {
+            values += a.values;
+            total += a.total();
+        }
+        EXPECT_EQ(values.inline_bytes, usage.values.inline_bytes);
+        EXPECT_EQ(values.heap_bytes, usage.values.heap_bytes);
+        EXPECT_EQ(total, usage.total());
+        EXPECT_LT(before.total(), usage.total());
+    }
+
+    class px_dispatch_test : public px_test
+    {
+    protected:
+        px_dispatch_test()
+        {
+            for (auto i = 0; i < 200; ++i)
+            {
+                names.push_back("option " + std::to_string(i));
+                tags.push_back("--option" + std::to_string(i));
+            }
+        }
+
+        void add_arguments(px::command_line& c, int n)
+        {
+            for (auto i = 0; i < n; ++i)
+            {
+                c.add_value_argument<int>(names[i], tags[i]);
+            }
+        }
+
+        // outlive the command lines, for PX_STATIC_METADATA
+        std::vector<std::string> names;
+        std::vector<std::string> tags;
+    };
+
+    TEST_F(px_dispatch_test, chooses_by_the_number_and_lengths_of_tags)
+    {
+        EXPECT_EQ(px::dispatch_strategy::automatic, cli.get_dispatch());
+        cli.add_flag_argument("verbose", "-v").set_alternate_tag("--verbose");
+        cli.add_value_argument<int>("count", "-n");
+        cli.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(px::dispatch_strategy::linear, cli.get_dispatch());
+
+        // mostly of one length, and short
+        add_arguments(cli, 8);
+        cli.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(px::dispatch_strategy::hashed, cli.get_dispatch());
+
+        px::command_line long_tags("long tags");
+        add_arguments(long_tags, 40);
+        long_tags.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(px::dispatch_strategy::inline_keys, long_tags.get_dispatch());
+
+        // too many to compare
+        px::command_line many("many");
+        add_arguments(many, 200);
+        many.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(px::dispatch_strategy::hashed, many.get_dispatch());
+
+        px::command_line few("few");
+        add_arguments(few, 2);
+        few.set_dispatch(px::dispatch_strategy::hashed);
+        EXPECT_EQ(px::dispatch_strategy::hashed, few.get_dispatch());
+        few.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(px::dispatch_strategy::hashed, few.get_dispatch());
+    }
+
+    TEST_F(px_dispatch_test, strategies_parse_the_same_values)
+    {
+        for (const auto strategy : { px::dispatch_strategy::linear, px::dispatch_strategy::hashed,
+            px::dispatch_strategy::inline_keys })
+        {
+            px::command_line c("cli");
+            add_arguments(c, 40);
+            auto& verbose = c.add_flag_argument("verbose", "-v").set_alternate_tag("--verbose");
+            auto& described = c.add_value_argument<std::string>("described", "--a-tag-too-long-for-an-inline-key");
+            auto& values = c.add_multi_value_argument<int>("values", "--values");
+            auto& input = c.add_positional_argument<std::string>("input");
+            c.set_dispatch(strategy);
+            c.parse(std::vector<std::string>{ programName, "--option7", "7", "--verbose", "--unknown", "--values", "1", "2",
+                "--option39", "39", "--a-tag-too-long-for-an-inline-key", "long", "--", "in" });
+
+            EXPECT_EQ(strategy, c.get_dispatch());
+            EXPECT_EQ(7, c.get<int>("option 7"));
+            EXPECT_EQ(39, c.get<int>("option 39"));
+            EXPECT_TRUE(verbose.get_value());
+            EXPECT_EQ((std::vector<int>{ 1, 2 }), values.get_value());
+            EXPECT_EQ("in", input.get_value());
+            EXPECT_EQ("long", described.get_value());
+        }
+    }
+
+    TEST_F(px_dispatch_test, inline_keys_match_whole_tags)
+    {
+        detail::tag_keys keys;
+        const std::vector<std::string> samples{ "-", "-v", "--fifteen-bytes", "--sixteen--bytes", std::string(31, 't'),
+            std::string(32, 't'), std::string(40, 'u'), "-v" };
+        for (std::uint32_t i = 0; i < samples.size(); ++i)
+        {
+            keys.add(samples[i], i + 1);
+        }
+        // the first of the repeated tag
+        for (std::uint32_t i = 0; i + 1 < samples.size(); ++i)
+        {
+            EXPECT_EQ(i + 1, keys.find(samples[i])) << samples[i];
+        }
+        for (const auto& other : { std::string("--v"), std::string("-v\0", 3), std::string("--fifteen-byte"),
+            std::string(30, 't'), std::string(33, 't'), std::string(), std::string(1, 'x') })
+        {
+            EXPECT_EQ(0u, keys.find(other)) << other;
+        }
+
+        // over several blocks of fingerprints
+        detail::tag_keys many;
+        for (std::uint32_t i = 0; i < tags.size(); ++i)
+        {
+            many.add(tags[i], i + 1);
+        }
+        for (std::uint32_t i = 0; i < tags.size(); ++i)
+        {
+            EXPECT_EQ(i + 1, many.find(tags[i])) << tags[i];
+        }
+        keys.clear();
+        EXPECT_EQ(0u, keys.find("-v"));
+    }
+
+    TEST_F(px_dispatch_test, tags_added_after_a_parse_are_found)
+    {
+        add_arguments(cli, 40);
+        cli.parse(std::vector<std::string>{ programName, "--option1", "1" });
+        auto& late = cli.add_value_argument<int>("late", "--late");
+        cli.parse(std::vector<std::string>{ programName, "--late", "2" });
+        EXPECT_EQ(2, late.get_value());
+    }
+
+    TEST_F(px_dispatch_test, tags_set_after_a_parse_are_found)
+    {
+        for (const auto strategy : { px::dispatch_strategy::linear, px::dispatch_strategy::hashed,
+            px::dispatch_strategy::inline_keys })
+        {
+            px::command_line c("cli");
+            add_arguments(c, 40);
+            c.set_dispatch(strategy);
+            auto& verbose = c.add_flag_argument("verbose", "-v");
+            c.parse(std::vector<std::string>{ programName });
+            verbose.set_alternate_tag("--verbose");
+            c.parse(std::vector<std::string>{ programName, "--verbose" });
+            EXPECT_TRUE(verbose.get_value());
+        }
+    }
+
+    TEST_F(px_dispatch_test, repeated_tag_is_parsed_by_each_of_its_arguments)
+    {
+        auto first = false;
+        auto second = false;
+        cli.add_flag_argument("first", "-v").bind(&first);
+        cli.add_flag_argument("second", "-v").bind(&second);
+        cli.set_dispatch(px::dispatch_strategy::hashed);
+        cli.parse(std::vector<std::string>{ programName, "-v" });
+        EXPECT_TRUE(first);
+        EXPECT_TRUE(second);
+    }
 }
@@ -0,0 +1,301 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// regression tests for the cost of parsing as schemas and command lines grow:
+// random schemas and arguments from a fixed seed are parsed at doubling
+// sizes, and the exponents of the power laws fitted to parse time and to
+// allocations must stay within budget, so a parse that turns quadratic in
+// the tokens or the arguments fails here rather than in production
+
+#include "px.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    std::atomic<std::size_t> allocations{ 0 };
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the replacements below pair malloc and free, which gcc cannot see through
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// counts the allocations of the parse being measured
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    constexpr std::mt19937::result_type seed = 20200517;
+
+    // the largest exponents allowed; time is given slack for noise, the
+    // allocations are counted exactly
+    constexpr double time_budget = 1.3;
+    constexpr double allocation_budget = 1.1;
+
+    struct cost
+    {
+        double size = 0;
+        double nanoseconds = 0;
+        double allocations = 0;
+    };
+
+    // the exponent of the power law fitted to the costs, by least squares on
+    // their logarithms
+    template <typename F>
+    double exponent(const std::vector<cost>& costs, F measure)
+    {
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (const auto& c : costs)
+        {
+            const auto x = std::log(c.size);
+            const auto y = std::log(std::max(1.0, measure(c)));
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        const auto n = static_cast<double>(costs.size());
+        return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    }
+
+    std::string describe(const std::vector<cost>& costs)
+    {
+        std::ostringstream s;
+        for (const auto& c : costs)
+        {
+            s << "\n  " << c.size << ": " << c.nanoseconds << " ns, " << c.allocations << " allocations";
+        }
+        return s.str();
+    }
+
+    std::string random_word(std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> length(1, 12);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::string word(length(random), ' ');
+        for (auto& c : word)
+        {
+            c = static_cast<char>(letter(random));
+        }
+        return word;
+    }
+
+    // a schema of random arguments, and random command lines for it
+    class random_schema
+    {
+    public:
+        enum class kind { flag, integer, string, integers, strings };
+
+        random_schema(std::size_t arguments, std::mt19937::result_type seed) :
+            flags(new bool[arguments]),
+            integers(arguments),
+            strings(arguments),
+            lists(arguments)
+        {
+            std::mt19937 random(seed);
+            std::uniform_int_distribution<int> pick(0, 4);
+            for (std::size_t i = 0; i < arguments; ++i)
+            {
+                const auto k = static_cast<kind>(pick(random));
+                const auto name = random_word(random) + std::to_string(i);
+                const auto tag = "--" + name;
+                switch (k)
+                {
+                case kind::flag:
+                    cli.add_flag_argument(name, tag).bind(&flags[i]);
+                    break;
+                case kind::integer:
+                    cli.add_value_argument<int>(name, tag).bind(&integers[i]);
+                    break;
+                case kind::string:
+                    cli.add_value_argument<std::string>(name, tag).bind(&strings[i]);
+                    break;
+                case kind::integers:
+                    cli.add_multi_value_argument<int>(name, tag).bind(&lists[i]);
+                    break;
+                case kind::strings:
+                    cli.add_multi_value_argument<std::string>(name, tag);
+                    break;
+                }
+                schema.emplace_back(k, tag);
+            }
+            cli.add_positional_argument<std::string>("rest");
+        }
+
+        // about the given number of tokens, after the program name
+        std::vector<std::string> generate(std::size_t tokens, std::mt19937::result_type seed) const
+        {
+            std::mt19937 random(seed);
+            std::uniform_int_distribution<std::size_t> argument(0, schema.size() - 1);
+            std::uniform_int_distribution<int> values(1, 4);
+            std::uniform_int_distribution<int> number(0, 1 << 20);
+            std::vector<std::string> args{ "fuzz" };
+            while (args.size() <= tokens)
+            {
+                const auto& [k, tag] = schema[argument(random)];
+                args.push_back(tag);
+                switch (k)
+                {
+                case kind::flag:
+                    break;
+                case kind::integer:
+                    args.push_back(std::to_string(number(random)));
+                    break;
+                case kind::string:
+                    args.push_back(random_word(random));
+                    break;
+                case kind::integers:
+                    for (auto n = values(random); n > 0; --n)
+                    {
+                        args.push_back(std::to_string(number(random)));
+                    }
+                    break;
+                case kind::strings:
+                    for (auto n = values(random); n > 0; --n)
+                    {
+                        args.push_back(random_word(random));
+                    }
+                    break;
+                }
+            }
+            return args;
+        }
+
+        px::command_line cli{ "fuzz" };
+
+    private:
+        std::vector<std::pair<kind, std::string>> schema;
+        std::unique_ptr<bool[]> flags;
+        std::vector<int> integers;
+        std::vector<std::string> strings;
+        std::vector<std::vector<int>> lists;
+    };
+
+    // the fastest of a few parses of args, each by a new command line from
+    // make, and the allocations of one
+    template <typename F>
+    cost measure(double size, const std::vector<std::string>& args, F make)
+    {
+        constexpr auto repetitions = 5;
+        cost c{ size, std::numeric_limits<double>::max(), 0 };
+        for (auto r = 0; r < repetitions; ++r)
+        {
+            auto schema = make();
+            const auto allocated = allocations.load();
+            const auto start = std::chrono::steady_clock::now();
+            schema->cli.parse(args);
+            const auto stop = std::chrono::steady_clock::now();
+            c.allocations = static_cast<double>(allocations.load() - allocated);
+            c.nanoseconds = std::min(c.nanoseconds, static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+        }
+        return c;
+    }
+
+    void expect_linear(const std::vector<cost>& costs)
+    {
+        const auto time = exponent(costs, [](const cost& c) { return c.nanoseconds; });
+        const auto allocated = exponent(costs, [](const cost& c) { return c.allocations; });
+        EXPECT_LE(time, time_budget) << "parse time grows as size^" << time << describe(costs);
+        EXPECT_LE(allocated, allocation_budget) << "allocations grow as size^" << allocated << describe(costs);
+    }
+}
+
+namespace px_tests
+{
+    class px_complexity_test : public ::testing::Test
+    {
+    };
+
+    TEST_F(px_complexity_test, parse_is_linear_in_the_tokens)
+    {
+        constexpr std::size_t arguments = 32;
+        std::vector<cost> costs;
+        for (std::size_t tokens = 1 << 10; tokens <= 1 << 15; tokens *= 2)
+        {
+            const auto args = random_schema(arguments, seed).generate(tokens, seed + tokens);
+            costs.push_back(measure(static_cast<double>(args.size()), args,
+                [arguments] { return std::make_unique<random_schema>(arguments, seed); }));
+        }
+        expect_linear(costs);
+    }
+
+    TEST_F(px_complexity_test, parse_is_linear_in_the_arguments)
+    {
+        constexpr std::size_t tokens = 1 << 11;
+        std::vector<cost> costs;
+        for (std::size_t arguments = 1 << 6; arguments <= 1 << 11; arguments *= 2)
+        {
+            const auto args = random_schema(arguments, seed + arguments).generate(tokens, seed);
+            costs.push_back(measure(static_cast<double>(arguments), args,
+                [arguments] { return std::make_unique<random_schema>(arguments, seed + arguments); }));
+        }
+        expect_linear(costs);
+    }
+
+    TEST_F(px_complexity_test, parse_is_linear_in_the_occurrences_of_a_bound_multi_value_argument)
+    {
+        struct schema
+        {
+            schema()
+            {
+                cli.add_multi_value_argument<int>("values", "-v").bind(&values);
+            }
+
+            px::command_line cli{ "fuzz" };
+            std::vector<int> values;
+        };
+
+        std::vector<cost> costs;
+        for (std::size_t occurrences = 1 << 10; occurrences <= 1 << 15; occurrences *= 2)
+        {
+            std::vector<std::string> args{ "fuzz" };
+            for (std::size_t i = 0; i < occurrences; ++i)
+            {
+                args.insert(args.end(), { "-v", std::to_string(i) });
+            }
+            costs.push_back(measure(static_cast<double>(occurrences), args, [] { return std::make_unique<schema>(); }));
+        }
+        expect_linear(costs);
+    }
+}
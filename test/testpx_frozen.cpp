@@ -0,0 +1,367 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_frozen.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+    const std::string programName("piet");
+
+    std::atomic<std::size_t> allocations{ 0 };
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the replacements below pair malloc and free, which gcc cannot see through
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// counts allocations, to see that a warm parse_result takes none
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// new_delete_resource asks for its alignment
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto a = static_cast<std::size_t>(alignment);
+    if (auto* p = std::aligned_alloc(a, (size + a - 1) / a * a))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace px_tests
+{
+    class px_frozen_test : public ::testing::Test
+    {
+    protected:
+        px::schema_builder builder{ "cli" };
+    };
+
+    TEST_F(px_frozen_test, can_parse_given_arguments)
+    {
+        const px::schema_key<bool> flag = builder.add_flag_argument("flag", "-f");
+        const px::schema_key<int> integer = builder.add_value_argument<int>("integer", "-i");
+        const px::schema_key<std::string> name = builder.add_value_argument<std::string>("name", "-n")
+            .set_alternate_tag("--name");
+        const auto schema = std::move(builder).freeze();
+
+        const std::vector<std::string> args{ programName, "-f", "-i", "42", "--name", "jan" };
+        const auto result = schema.parse(args);
+
+        EXPECT_EQ(3u, result.size());
+        EXPECT_TRUE(result.get(flag));
+        EXPECT_EQ(42, result.get(integer));
+        EXPECT_EQ("jan", result.get(name));
+    }
+
+    TEST_F(px_frozen_test, stores_only_given_arguments)
+    {
+        std::vector<px::schema_key<int>> keys;
+        for (auto i = 0; i < 3000; ++i)
+        {
+            keys.push_back(builder.add_value_argument<int>("option", "--opt" + std::to_string(i)));
+        }
+        const auto schema = std::move(builder).freeze();
+
+        const std::vector<std::string> args{ programName, "--opt2999", "3", "--opt7", "7" };
+        const auto result = schema.parse(args);
+
+        EXPECT_EQ(2u, result.size());
+        EXPECT_EQ(7, result.get(keys[7]));
+        EXPECT_EQ(3, result.get(keys[2999]));
+        EXPECT_FALSE(result.has_value(keys[8]));
+        EXPECT_EQ(nullptr, result.find(keys[8]));
+    }
+
+    TEST_F(px_frozen_test, can_parse_multi_values)
+    {
+        const auto values = builder.add_multi_value_argument<int>("values", "-v").key();
+        const auto flag = builder.add_flag_argument("flag", "-f").key();
+        const auto schema = std::move(builder).freeze();
+
+        const std::vector<std::string> args{ programName, "-v", "1", "2", "-f", "-v", "3" };
+        const auto result = schema.parse(args);
+
+        EXPECT_EQ(std::pmr::vector<int>({ 1, 2, 3 }), result.get(values));
+        EXPECT_TRUE(result.get(flag));
+    }
+
+    TEST_F(px_frozen_test, absent_flags_and_multi_values_are_empty)
+    {
+        const auto values = builder.add_multi_value_argument<int>("values", "-v").key();
+        const auto flag = builder.add_flag_argument("flag", "-f").key();
+        const auto integer = builder.add_value_argument<int>("integer", "-i").key();
+        const auto schema = std::move(builder).freeze();
+
+        const auto result = schema.parse(std::vector<std::string>{ programName });
+
+        EXPECT_TRUE(result.get(values).empty());
+        EXPECT_FALSE(result.get(flag));
+        EXPECT_THROW(result.get(integer), std::runtime_error);
+    }
+
+    TEST_F(px_frozen_test, can_reuse_parse_result)
+    {
+        const auto name = builder.add_value_argument<std::string>("name", "-n").key();
+        const auto schema = std::move(builder).freeze();
+
+        px::parse_result result;
+        schema.parse(std::vector<std::string>{ programName, "-n", std::string(100, 'a') }, result);
+        EXPECT_EQ(std::string(100, 'a'), result.get(name));
+
+        schema.parse(std::vector<std::string>{ programName }, result);
+        EXPECT_EQ(0u, result.size());
+
+        schema.parse(std::vector<std::string>{ programName, "-n", "b" }, result);
+        EXPECT_EQ("b", result.get(name));
+    }
+
+    TEST_F(px_frozen_test, warm_parse_result_does_not_allocate)
+    {
+        const auto count = builder.add_value_argument<int>("count", "-n").key();
+        const auto values = builder.add_multi_value_argument<int>("values", "-v").key();
+        const auto schema = std::move(builder).freeze();
+
+        // more values than the first buffer holds
+        std::vector<std::string> strings{ programName, "-n", "3", "-v" };
+        for (auto i = 0; i < 1000; ++i)
+        {
+            strings.push_back(std::to_string(i));
+        }
+        const std::vector<std::string_view> args(strings.begin(), strings.end());
+
+        px::parse_result result;
+        schema.parse(args, result);
+        schema.parse(args, result);
+        const auto before = allocations.load();
+        schema.parse(args, result);
+        schema.parse(args, result);
+        EXPECT_EQ(before, allocations.load());
+        EXPECT_EQ(3, result.get(count));
+        EXPECT_EQ(1000u, result.get(values).size());
+    }
+
+    TEST_F(px_frozen_test, destroying_and_moving_a_parse_result_do_not_allocate)
+    {
+        builder.add_multi_value_argument<int>("values", "-v");
+        const auto schema = std::move(builder).freeze();
+
+        std::vector<std::string> strings{ programName, "-v" };
+        for (auto i = 0; i < 1000; ++i)
+        {
+            strings.push_back(std::to_string(i));
+        }
+        const std::vector<std::string_view> args(strings.begin(), strings.end());
+
+        // each outgrew its first buffer, which only clear grows
+        auto result = std::make_unique<px::parse_result>();
+        px::parse_result other;
+        schema.parse(args, *result);
+        schema.parse(args, other);
+        const auto before = allocations.load();
+        other = std::move(*result);
+        result.reset();
+        EXPECT_EQ(before, allocations.load());
+    }
+
+    TEST_F(px_frozen_test, last_value_wins)
+    {
+        const auto integer = builder.add_value_argument<int>("integer", "-i").key();
+        const auto schema = std::move(builder).freeze();
+
+        const auto result = schema.parse(std::vector<std::string>{ programName, "-i", "1", "-i", "2" });
+
+        EXPECT_EQ(1u, result.size());
+        EXPECT_EQ(2, result.get(integer));
+    }
+
+    TEST_F(px_frozen_test, stops_at_separator)
+    {
+        const auto flag = builder.add_flag_argument("flag", "-f").key();
+        const auto schema = std::move(builder).freeze();
+
+        const auto result = schema.parse(std::vector<std::string>{ programName, "--", "-f" });
+
+        EXPECT_FALSE(result.get(flag));
+    }
+
+    TEST_F(px_frozen_test, throws_on_missing_required_argument)
+    {
+        builder.add_value_argument<int>("integer", "-i").set_required(true);
+        const auto schema = std::move(builder).freeze();
+
+        EXPECT_THROW(schema.parse(std::vector<std::string>{ programName }), std::runtime_error);
+        EXPECT_NO_THROW(schema.parse(std::vector<std::string>{ programName, "-i", "1" }));
+    }
+
+    TEST_F(px_frozen_test, throws_on_invalid_value)
+    {
+        builder.add_value_argument<int>("integer", "-i").set_validator([](auto i) { return i > 0; });
+        builder.add_multi_value_argument<int>("values", "-v")
+            .set_validator([](const auto& v) { return v.size() < 3; });
+        const auto schema = std::move(builder).freeze();
+
+        EXPECT_THROW(schema.parse(std::vector<std::string>{ programName, "-i", "0" }), std::runtime_error);
+        EXPECT_NO_THROW(schema.parse(std::vector<std::string>{ programName, "-i", "1" }));
+        EXPECT_THROW(schema.parse(std::vector<std::string>{ programName, "-v", "1", "2", "3" }), std::runtime_error);
+    }
+
+    TEST_F(px_frozen_test, throws_on_tag_without_value)
+    {
+        builder.add_value_argument<int>("integer", "-i");
+        const auto schema = std::move(builder).freeze();
+
+        EXPECT_THROW(schema.parse(std::vector<std::string>{ programName, "-i" }), std::runtime_error);
+    }
+
+    TEST_F(px_frozen_test, throws_on_duplicate_tag)
+    {
+        builder.add_value_argument<int>("integer", "-i");
+        builder.add_flag_argument("flag", "-f").set_alternate_tag("-i");
+
+        EXPECT_THROW(std::move(builder).freeze(), std::logic_error);
+    }
+
+    TEST_F(px_frozen_test, prints_help_as_command_line)
+    {
+        builder.add_value_argument<int>("integer", "-i")
+            .set_alternate_tag("--integer")
+            .set_description("an integer")
+            .set_required(true);
+        const auto schema = std::move(builder).freeze();
+
+        std::ostringstream frozen;
+        schema.print_help(frozen);
+
+        px::command_line cli("cli");
+        cli.add_value_argument<int>("integer", "-i")
+            .set_alternate_tag("--integer")
+            .set_description("an integer")
+            .set_required(true);
+        std::ostringstream dynamic;
+        cli.print_help(dynamic);
+
+        EXPECT_EQ(dynamic.str(), frozen.str());
+    }
+
+    TEST_F(px_frozen_test, override_layer_falls_through_to_base)
+    {
+        const auto integer = builder.add_value_argument<int>("integer", "-i").set_required(true).key();
+        const auto name = builder.add_value_argument<std::string>("name", "-n").key();
+        const auto values = builder.add_multi_value_argument<int>("values", "-v").key();
+        const auto flag = builder.add_flag_argument("flag", "-f").key();
+        const auto schema = std::move(builder).freeze();
+        const auto base = schema.parse(std::vector<std::string>{ programName, "-i", "1", "-n", "jan", "-v", "1", "2" });
+
+        px::override_layer layer(schema, base);
+        layer.parse(std::vector<std::string>{ programName, "-n", "piet", "-v", "3", "-f" });
+
+        EXPECT_EQ(3u, layer.size());
+        EXPECT_EQ(1, layer.get(integer));
+        EXPECT_FALSE(layer.is_overridden(integer));
+        EXPECT_EQ("piet", layer.get(name));
+        EXPECT_TRUE(layer.is_overridden(name));
+        EXPECT_EQ(std::pmr::vector<int>({ 3 }), layer.get(values));
+        EXPECT_TRUE(layer.get(flag));
+        EXPECT_EQ("jan", base.get(name));
+        EXPECT_FALSE(base.get(flag));
+    }
+
+    TEST_F(px_frozen_test, override_layer_can_be_reused)
+    {
+        const auto integer = builder.add_value_argument<int>("integer", "-i").key();
+        const auto other = builder.add_value_argument<int>("other", "-o").key();
+        const auto schema = std::move(builder).freeze();
+        const auto base = schema.parse(std::vector<std::string>{ programName, "-i", "1" });
+
+        px::override_layer layer(schema, base);
+        layer.parse(std::vector<std::string>{ programName, "-i", "2", "-o", "3" });
+        EXPECT_EQ(2, layer.get(integer));
+        EXPECT_EQ(3, layer.get(other));
+
+        layer.parse(std::vector<std::string>{ programName });
+        EXPECT_EQ(0u, layer.size());
+        EXPECT_EQ(1, layer.get(integer));
+        EXPECT_FALSE(layer.has_value(other));
+        EXPECT_THROW(layer.get(other), std::runtime_error);
+    }
+
+    TEST_F(px_frozen_test, override_layer_validates_overrides)
+    {
+        const auto integer = builder.add_value_argument<int>("integer", "-i")
+            .set_required(true)
+            .set_validator([](auto i) { return i > 0; })
+            .key();
+        const auto schema = std::move(builder).freeze();
+        const auto base = schema.parse(std::vector<std::string>{ programName, "-i", "1" });
+
+        px::override_layer layer(schema, base);
+        EXPECT_NO_THROW(layer.parse(std::vector<std::string>{ programName }));
+        EXPECT_THROW(layer.parse(std::vector<std::string>{ programName, "-i", "0" }), std::runtime_error);
+        EXPECT_EQ(0u, layer.size());
+        EXPECT_EQ(1, layer.get(integer));
+    }
+
+    TEST_F(px_frozen_test, throws_on_exceeding_limits_before_converting)
+    {
+        const auto values = builder.add_multi_value_argument<int>("values", "-v").key();
+        px::parse_limits limits;
+        limits.max_values_per_argument = 2;
+        builder.set_limits(limits);
+        const auto schema = std::move(builder).freeze();
+
+        // the last value does not convert, but the limit is checked first
+        EXPECT_THROW(schema.parse(std::vector<std::string>{ programName, "-v", "1", "2", "x" }), px::limit_exceeded);
+        const auto result = schema.parse(std::vector<std::string>{ programName, "-v", "1", "2", "-v", "3" });
+        EXPECT_EQ(std::pmr::vector<int>({ 1, 2, 3 }), result.get(values));
+    }
+}
@@ -0,0 +1,171 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_glob.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+
+namespace
+{
+    const std::string programName("piet");
+}
+
+namespace px_tests
+{
+    namespace fs = std::filesystem;
+
+    class px_glob_test : public ::testing::Test
+    {
+    protected:
+        px_glob_test()
+        {
+            for (const auto* name : { "data/a.parquet", "data/b.csv", "data/2024/01/c.parquet", "data/2024/02/d.parquet",
+                "data/2024/02/e.csv", "data/.hidden/f.parquet", "data/.g.parquet", "other/h.parquet", "s/t/u/v" })
+            {
+                const auto path = directory / name;
+                fs::create_directories(path.parent_path());
+                std::ofstream(path) << name;
+            }
+        }
+
+        ~px_glob_test() override
+        {
+            fs::remove_all(directory);
+        }
+
+        std::vector<fs::path> expand(const std::string& pattern, const px::glob_options& options = {})
+        {
+            std::vector<fs::path> paths;
+            px::expand_glob((directory / pattern).string(), paths, options);
+            return paths;
+        }
+
+        std::vector<fs::path> in_directory(std::initializer_list<const char*> names)
+        {
+            std::vector<fs::path> paths;
+            for (const auto* name : names)
+            {
+                paths.push_back(directory / name);
+            }
+            return paths;
+        }
+
+        const fs::path directory = fs::temp_directory_path() /
+            ("px_glob_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+    };
+
+    TEST_F(px_glob_test, matches_names_as_a_shell)
+    {
+        EXPECT_TRUE(detail::glob_match("*.parquet", "a.parquet"));
+        EXPECT_FALSE(detail::glob_match("*.parquet", "a.parquet.tmp"));
+        EXPECT_FALSE(detail::glob_match("*.parquet", ".a.parquet"));
+        EXPECT_TRUE(detail::glob_match(".*", ".a"));
+        EXPECT_TRUE(detail::glob_match("a?c", "abc"));
+        EXPECT_FALSE(detail::glob_match("a?c", "ac"));
+        EXPECT_TRUE(detail::glob_match("[a-c]*[!0-9]", "b12x"));
+        EXPECT_FALSE(detail::glob_match("[a-c]*[!0-9]", "b123"));
+        EXPECT_TRUE(detail::glob_match("[]x]", "]"));
+        EXPECT_TRUE(detail::glob_match("a[b", "a[b"));
+        EXPECT_TRUE(detail::glob_match("*a*b*", "xxaxxbxx"));
+    }
+
+    TEST_F(px_glob_test, expands_patterns_in_sorted_order)
+    {
+        EXPECT_EQ(in_directory({ "data/2024/01/c.parquet", "data/2024/02/d.parquet", "data/a.parquet" }),
+            expand("data/**/*.parquet"));
+        EXPECT_EQ(in_directory({ "data/2024/02/d.parquet", "data/2024/02/e.csv" }), expand("data/*/0[2-9]/*"));
+        EXPECT_EQ(in_directory({ "data/a.parquet", "other/h.parquet" }), expand("*/?.parquet"));
+        EXPECT_EQ(in_directory({ "data/.g.parquet" }), expand("data/.*.parquet"));
+    }
+
+    TEST_F(px_glob_test, unsorted_expansion_finds_the_same_paths_on_any_number_of_threads)
+    {
+        const auto sorted = expand("**/*");
+        for (const auto threads : { 1, 2, 8 })
+        {
+            px::glob_options options;
+            options.order = px::glob_order::unsorted;
+            options.threads = threads;
+            auto unsorted = expand("**/**/*", options);
+            std::sort(unsorted.begin(), unsorted.end());
+            EXPECT_EQ(sorted, unsorted) << threads << " threads";
+        }
+
+        // paths short enough to be stored inline in the path, found twice
+        const auto previous = fs::current_path();
+        fs::current_path(directory);
+        std::vector<fs::path> short_sorted, short_unsorted;
+        px::expand_glob("s/**/*/**/*", short_sorted);
+        px::glob_options options;
+        options.order = px::glob_order::unsorted;
+        options.threads = 1;
+        px::expand_glob("s/**/*/**/*", short_unsorted, options);
+        fs::current_path(previous);
+        std::sort(short_unsorted.begin(), short_unsorted.end());
+        EXPECT_EQ(short_sorted, short_unsorted);
+    }
+
+    TEST_F(px_glob_test, expands_patterns_relative_to_the_working_directory)
+    {
+        const auto previous = fs::current_path();
+        fs::current_path(directory / "data");
+        const auto relative = [](const char* pattern, const px::glob_options& options = {})
+        {
+            std::vector<fs::path> paths;
+            px::expand_glob(pattern, paths, options);
+            return paths;
+        };
+        std::vector<fs::path> all, top, nested;
+        EXPECT_NO_THROW(all = relative("**/*"));
+        EXPECT_NO_THROW(top = relative("*"));
+        EXPECT_NO_THROW(nested = relative("*/0?"));
+        const auto in_any = relative("**/**/*");
+        fs::current_path(previous);
+
+        EXPECT_EQ((std::vector<fs::path>{ "2024", "2024/01", "2024/01/c.parquet", "2024/02", "2024/02/d.parquet",
+            "2024/02/e.csv", "a.parquet", "b.csv" }), all);
+        EXPECT_EQ((std::vector<fs::path>{ "2024", "a.parquet", "b.csv" }), top);
+        EXPECT_EQ((std::vector<fs::path>{ "2024/01", "2024/02" }), nested);
+        EXPECT_EQ(all, in_any);
+    }
+
+    TEST_F(px_glob_test, validates_paths_as_they_are_found)
+    {
+        px::glob_options options;
+        options.validator = [](const fs::path& p) { return p.extension() == ".parquet"; };
+        EXPECT_NO_THROW(expand("data/**/*.parquet", options));
+        EXPECT_THROW(expand("data/**/*", options), std::runtime_error);
+        EXPECT_THROW(expand("data/b.csv", options), std::runtime_error);
+        EXPECT_THROW(expand("data/**/*.json"), std::runtime_error);
+    }
+
+    TEST_F(px_glob_test, multi_value_path_argument_expands_its_values)
+    {
+        px::command_line cli("the program");
+        auto& inputs = cli.add_multi_value_argument<fs::path>("inputs", "-i")
+            .set_expander(px::glob());
+
+        const std::vector<std::string> args{ programName, "-i", (directory / "data/2024/*/*.parquet").string(),
+            (directory / "not/a/pattern").string(), (directory / "other/*").string() };
+        cli.parse(args);
+
+        EXPECT_EQ(in_directory({ "data/2024/01/c.parquet", "data/2024/02/d.parquet", "not/a/pattern", "other/h.parquet" }),
+            inputs.get_value());
+    }
+}
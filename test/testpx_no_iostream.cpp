@@ -0,0 +1,78 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define PX_NO_IOSTREAM
+#include "px.h"
+
+#include <gtest/gtest.h>
+#include <filesystem>
+
+namespace
+{
+    const std::string programName("piet");
+}
+
+namespace px_tests
+{
+    class px_no_iostream_test : public ::testing::Test
+    {
+    protected:
+        px::command_line cli{ "cli" };
+    };
+
+    TEST_F(px_no_iostream_test, can_parse_without_iostreams)
+    {
+        auto i = 0;
+        auto f = 0.f;
+        auto b = false;
+        std::filesystem::path p;
+        cli.add_value_argument<int>("integer", "-i").bind(&i);
+        cli.add_value_argument<float>("float", "-f").bind(&f);
+        cli.add_value_argument<bool>("boolean", "-b").bind(&b);
+        cli.add_value_argument<std::filesystem::path>("path", "-p").bind(&p);
+
+        const std::vector<std::string> args{ programName, "-i", "+42", "-f", "1.5", "-b", "true", "-p", "a b" };
+        cli.parse(args);
+
+        EXPECT_EQ(42, i);
+        EXPECT_FLOAT_EQ(1.5f, f);
+        EXPECT_TRUE(b);
+        EXPECT_EQ(std::filesystem::path("a b"), p);
+    }
+
+    TEST_F(px_no_iostream_test, throws_on_trailing_characters)
+    {
+        cli.add_value_argument<int>("integer", "-i");
+
+        const std::vector<std::string> args{ programName, "-i", "42x" };
+        EXPECT_THROW(cli.parse(args), std::runtime_error);
+    }
+
+    TEST_F(px_no_iostream_test, can_print_help_to_string)
+    {
+        cli.add_value_argument<int>("integer", "-i")
+            .set_alternate_tag("--integer")
+            .set_description("an integer");
+
+        std::string help;
+        px::string_sink sink(help);
+        cli.print_help(sink);
+
+        EXPECT_EQ("cli\n   -i, --integer    an integer\n\n", help);
+    }
+}
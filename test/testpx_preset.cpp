@@ -0,0 +1,124 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_preset.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+
+namespace
+{
+    struct settings
+    {
+        int threads = 1;
+        bool verbose = false;
+        std::string_view mode = "default";
+        double ratio = 0.;
+    };
+
+    constexpr px::static_command_line cli(
+        px::static_argument("-t", &settings::threads)
+            .set_alternate_tag("--threads")
+            .set_validator([](int t) { return t > 0; }),
+        px::static_argument("-v", &settings::verbose),
+        px::static_argument("-m", &settings::mode)
+            .set_required(true),
+        px::static_argument("-r", &settings::ratio));
+
+    // parsed and validated by the compiler
+    constexpr settings fast = cli.parse("--threads 8 -v -m 'very fast' -r 0.25");
+    static_assert(fast.threads == 8);
+    static_assert(fast.verbose);
+    static_assert(fast.mode == "very fast");
+    static_assert(fast.ratio == 0.25);
+
+    struct limits
+    {
+        std::int64_t i = 0;
+        std::uint32_t u = 0;
+    };
+
+    constexpr px::static_command_line limits_cli(
+        px::static_argument("-i", &limits::i),
+        px::static_argument("-u", &limits::u));
+
+    static_assert(limits_cli.parse("-i -9223372036854775808").i == INT64_MIN);
+    static_assert(limits_cli.parse("-i +9223372036854775807").i == INT64_MAX);
+    static_assert(limits_cli.parse("-u 4294967295").u == UINT32_MAX);
+
+    const std::string programName("piet");
+}
+
+namespace px_tests
+{
+    TEST(px_preset_test, unset_members_keep_their_defaults)
+    {
+        constexpr auto s = cli.parse("-m slow");
+        EXPECT_EQ(1, s.threads);
+        EXPECT_FALSE(s.verbose);
+        EXPECT_EQ("slow", s.mode);
+    }
+
+    TEST(px_preset_test, throws_on_invalid_preset_at_run_time)
+    {
+        EXPECT_THROW(cli.parse("-m slow -t 0"), std::runtime_error);
+        EXPECT_THROW(cli.parse("-t 2"), std::runtime_error);
+        EXPECT_THROW(cli.parse("-m slow -x"), std::runtime_error);
+        EXPECT_THROW(cli.parse("-m slow -t"), std::runtime_error);
+        EXPECT_THROW(cli.parse("-m 'slow"), std::runtime_error);
+    }
+
+    TEST(px_preset_test, throws_on_out_of_range_values)
+    {
+        EXPECT_THROW(limits_cli.parse("-i 9223372036854775808"), std::runtime_error);
+        EXPECT_THROW(limits_cli.parse("-u 4294967296"), std::runtime_error);
+        EXPECT_THROW(limits_cli.parse("-u -1"), std::runtime_error);
+        EXPECT_THROW(cli.parse("-m x -r 1e400"), std::runtime_error);
+    }
+
+    TEST(px_preset_test, can_parse_argv_at_run_time)
+    {
+        std::vector<std::string> args{ programName, "-t", "3", "-m", "argv" };
+        std::vector<char*> argv;
+        for (auto& a : args)
+        {
+            argv.push_back(a.data());
+        }
+
+        const auto s = cli.parse(static_cast<int>(argv.size()), argv.data());
+        EXPECT_EQ(3, s.threads);
+        EXPECT_EQ("argv", s.mode);
+    }
+
+    TEST(px_preset_test, parses_any_floating_point_value_at_run_time)
+    {
+        // beyond what constant evaluation can round exactly
+        for (const auto& [text, value] : std::vector<std::pair<std::string, double>>{
+            { "1e-30", 1e-30 }, { "1e300", 1e300 }, { "0.10000000000000001", 0.10000000000000001 }, { "+2.5", 2.5 } })
+        {
+            std::vector<std::string> args{ programName, "-m", "argv", "-r", text };
+            std::vector<char*> argv;
+            for (auto& a : args)
+            {
+                argv.push_back(a.data());
+            }
+            EXPECT_EQ(value, cli.parse(static_cast<int>(argv.size()), argv.data()).ratio);
+        }
+        EXPECT_THROW(cli.parse("-m x -r 1.5x"), std::runtime_error);
+    }
+}
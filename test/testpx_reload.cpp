@@ -0,0 +1,155 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_reload.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+
+namespace
+{
+    void write_file(const std::filesystem::path& path, const std::string& text)
+    {
+        std::ofstream(path, std::ios::trunc) << text;
+    }
+}
+
+namespace px_tests
+{
+    class px_reload_test : public ::testing::Test
+    {
+    protected:
+        px_reload_test()
+        {
+            threads = builder.add_value_argument<int>("threads", "-t")
+                .set_validator([](auto t) { return t > 0; });
+            mode = builder.add_value_argument<std::string>("mode", "-m");
+            verbose = builder.add_flag_argument("verbose", "-v");
+        }
+
+        ~px_reload_test() override
+        {
+            std::filesystem::remove_all(directory);
+        }
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() /
+            ("px_reload_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::path path = (std::filesystem::create_directories(directory), directory / "px.conf");
+        px::schema_builder builder{ "cli" };
+        px::schema_key<int> threads{};
+        px::schema_key<std::string> mode{};
+        px::schema_key<bool> verbose{};
+    };
+
+    TEST_F(px_reload_test, can_tokenize_config)
+    {
+        const auto args = detail::tokenize_config("# comment\n-t 4\n\n  -m 'very fast' # not a comment\n");
+
+        EXPECT_EQ(std::vector<std::string>({ "", "-t", "4", "-m", "very fast", "#", "not", "a", "comment" }), args);
+    }
+
+    TEST_F(px_reload_test, publishes_values_on_reload)
+    {
+        const auto schema = std::move(builder).freeze();
+        write_file(path, "-t 4\n-m fast\n");
+
+        px::config_reloader config(schema, path);
+        const auto& t = config.bind(threads, 1);
+        const auto& m = config.bind(mode, std::string("default"));
+        const auto& v = config.bind(verbose, false);
+        EXPECT_EQ(1, t.load());
+        EXPECT_EQ("default", *m.load());
+
+        EXPECT_TRUE(config.reload());
+        EXPECT_EQ(4, t.load());
+        EXPECT_EQ("fast", *m.load());
+        EXPECT_FALSE(v.load());
+        EXPECT_EQ(4, config.snapshot()->get(threads));
+    }
+
+    TEST_F(px_reload_test, publishes_only_changes)
+    {
+        const auto schema = std::move(builder).freeze();
+        write_file(path, "-t 4 -m fast");
+
+        px::config_reloader config(schema, path);
+        const auto& m = config.bind(mode, std::string("default"));
+        config.reload();
+        const auto before = m.load();
+
+        EXPECT_FALSE(config.reload());
+        write_file(path, "-t 8 -m fast");
+        EXPECT_FALSE(config.reload());
+        EXPECT_EQ(before, m.load());
+        EXPECT_EQ(8, config.snapshot()->get(threads));
+
+        write_file(path, "-t 8");
+        EXPECT_TRUE(config.reload());
+        EXPECT_EQ("default", *m.load());
+    }
+
+    TEST_F(px_reload_test, keeps_values_of_invalid_config)
+    {
+        const auto schema = std::move(builder).freeze();
+        write_file(path, "-t 4");
+
+        px::config_reloader config(schema, path);
+        const auto& t = config.bind(threads, 1);
+        config.reload();
+
+        write_file(path, "-t 0");
+        EXPECT_THROW(config.reload(), std::runtime_error);
+        EXPECT_EQ(4, t.load());
+
+        std::filesystem::remove(path);
+        EXPECT_THROW(config.reload(), std::runtime_error);
+        EXPECT_EQ(4, t.load());
+    }
+
+    TEST_F(px_reload_test, binds_after_reload)
+    {
+        const auto schema = std::move(builder).freeze();
+        write_file(path, "-t 4");
+
+        px::config_reloader config(schema, path);
+        config.reload();
+
+        EXPECT_EQ(4, config.bind(threads, 1).load());
+    }
+
+    TEST_F(px_reload_test, watches_config_file)
+    {
+        const auto schema = std::move(builder).freeze();
+        write_file(path, "-t 4");
+
+        px::config_reloader config(schema, path);
+        const auto& t = config.bind(threads, 1);
+        config.reload();
+        config.watch({}, std::chrono::milliseconds(10));
+
+        write_file(path, "-t 16");
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (t.load() != 16 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        config.stop();
+
+        EXPECT_EQ(16, t.load());
+    }
+}
@@ -0,0 +1,251 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_response.h"
+#include "px_frozen.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+
+namespace
+{
+    const std::string programName("piet");
+
+    std::vector<std::string_view> tokenize_sequentially(std::string_view text)
+    {
+        std::vector<std::string_view> tokens;
+        if (const auto quote = detail::tokenize_response(text, 0, text.size(), tokens); quote != std::string_view::npos)
+        {
+            detail::throw_unterminated_quote(quote);
+        }
+        return tokens;
+    }
+
+    std::string error_of(const std::function<void()>& f)
+    {
+        try
+        {
+            f();
+        }
+        catch (const std::runtime_error& e)
+        {
+            return e.what();
+        }
+        return {};
+    }
+}
+
+namespace px_tests
+{
+    class px_response_test : public ::testing::Test
+    {
+    protected:
+        ~px_response_test() override
+        {
+            std::filesystem::remove_all(directory);
+        }
+
+        std::filesystem::path write_file(const std::string& name, const std::string& text)
+        {
+            const auto path = directory / name;
+            std::ofstream(path, std::ios::binary) << text;
+            return path;
+        }
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() /
+            ("px_response_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        bool created = std::filesystem::create_directories(directory);
+    };
+
+    TEST_F(px_response_test, parallel_tokens_match_sequential_tokens)
+    {
+        // quoted arguments spanning lines, and so chunks
+        std::string text;
+        for (auto i = 0; i < 2000; ++i)
+        {
+            text += "-i " + std::to_string(i) + " --name 'line\n" + std::to_string(i) + "\nend'\n";
+            if (i % 7 == 0)
+            {
+                text += "\"a\n\n\nquote\"x 'b' \n\n";
+            }
+        }
+
+        const auto sequential = tokenize_sequentially(text);
+        for (const auto threads : { 1, 2, 3, 8, 64 })
+        {
+            EXPECT_EQ(sequential, detail::tokenize_response_parallel(text, threads, 16)) << threads << " threads";
+        }
+    }
+
+    TEST_F(px_response_test, reports_unterminated_quote_as_sequential_tokenizing)
+    {
+        std::string text;
+        for (auto i = 0; i < 1000; ++i)
+        {
+            text += "-i " + std::to_string(i) + "\n";
+        }
+        text += "'open\n";
+        for (auto i = 0; i < 1000; ++i)
+        {
+            text += "-i " + std::to_string(i) + "\n";
+        }
+
+        const auto sequential = error_of([&] { tokenize_sequentially(text); });
+        EXPECT_NE("", sequential);
+        for (const auto threads : { 2, 8 })
+        {
+            EXPECT_EQ(sequential, error_of([&] { detail::tokenize_response_parallel(text, threads, 16); }));
+        }
+    }
+
+    TEST_F(px_response_test, expands_response_files)
+    {
+        const auto inner = write_file("inner.rsp", "-v 3 4\n");
+        const auto outer = write_file("outer.rsp", "-n 'a name'\n-v 1 2 @" + inner.string() + "\n");
+
+        px::response_files files;
+        const std::vector<std::string> given{ programName, "@" + outer.string(), "-f", "--", "@x" };
+        const auto args = files.expand(given);
+
+        EXPECT_EQ(std::vector<std::string_view>({ programName, "-n", "a name", "-v", "1", "2", "-v", "3", "4", "-f", "--", "@x" }), args);
+
+        px::schema_builder builder("cli");
+        const auto values = builder.add_multi_value_argument<int>("values", "-v").key();
+        const auto name = builder.add_value_argument<std::string>("name", "-n").key();
+        const auto schema = std::move(builder).freeze();
+        px::parse_result result;
+        schema.parse(args, result);
+        EXPECT_EQ(std::pmr::vector<int>({ 1, 2, 3, 4 }), result.get(values));
+        EXPECT_EQ("a name", result.get(name));
+    }
+
+    TEST_F(px_response_test, bounds_include_depth)
+    {
+        const auto inner = write_file("inner.rsp", "-v 1\n");
+        const auto outer = write_file("outer.rsp", "@" + inner.string());
+        const auto self = write_file("self.rsp", "@" + (directory / "self.rsp").string());
+
+        px::parse_limits limits;
+        limits.max_include_depth = 1;
+        px::response_files bounded(limits);
+        EXPECT_NO_THROW(bounded.expand(std::vector<std::string>{ programName, "@" + inner.string() }));
+        EXPECT_THROW(bounded.expand(std::vector<std::string>{ programName, "@" + outer.string() }), px::limit_exceeded);
+
+        px::response_files unbounded;
+        EXPECT_THROW(unbounded.expand(std::vector<std::string>{ programName, "@" + self.string() }), std::runtime_error);
+    }
+
+    TEST_F(px_response_test, command_line_expands_a_lone_response_file_when_set)
+    {
+        const auto file = write_file("args.rsp", "-n 'two words'\n-c 3\n");
+        const auto missing = "@" + (directory / "missing").string();
+        px::command_line cli("cli");
+        const auto& name = cli.add_value_argument<std::string>("name", "-n");
+        const auto& count = cli.add_value_argument<int>("count", "-c");
+        const auto& rest = cli.add_positional_argument<std::string>("rest");
+
+        // not unless asked for
+        cli.parse(std::vector<std::string>{ programName, "@" + file.string() });
+        EXPECT_EQ("@" + file.string(), rest.get_value());
+
+        cli.set_response_files(true);
+        cli.parse(std::vector<std::string>{ programName, "@" + file.string() });
+        EXPECT_EQ("two words", name.get_value());
+        EXPECT_EQ(3, count.get_value());
+
+        // only a lone @path is expanded, and one that cannot be read throws
+        cli.parse(std::vector<std::string>{ programName, "-c", "4", "@" + file.string() });
+        EXPECT_EQ(4, count.get_value());
+        EXPECT_EQ("@" + file.string(), rest.get_value());
+        EXPECT_THROW(cli.parse(std::vector<std::string>{ programName, missing }), std::runtime_error);
+
+        const auto unterminated = write_file("unterminated.rsp", "-n 'two words");
+        EXPECT_THROW(cli.parse(std::vector<std::string>{ programName, "@" + unterminated.string() }), std::runtime_error);
+    }
+
+    TEST_F(px_response_test, command_line_bounds_a_response_file_by_the_limits)
+    {
+        const auto file = write_file("args.rsp", "-c 3 -c 4 -c 5\n");
+        px::command_line cli("cli");
+        cli.add_multi_value_argument<int>("count", "-c");
+        cli.set_response_files(true);
+        const std::vector<std::string> args{ programName, "@" + file.string() };
+
+        const auto limit = [&](auto set) -> std::optional<px::limit_exceeded::limit>
+        {
+            px::parse_limits limits;
+            set(limits);
+            cli.set_limits(limits);
+            try
+            {
+                cli.parse(args);
+            }
+            catch (const px::limit_exceeded& e)
+            {
+                return e.which();
+            }
+            return std::nullopt;
+        };
+        using px::limit_exceeded;
+        EXPECT_EQ(std::nullopt, limit([](auto&) {}));
+        EXPECT_EQ(limit_exceeded::limit::include_depth, limit([](auto& l) { l.max_include_depth = 0; }));
+        EXPECT_EQ(std::nullopt, limit([](auto& l) { l.max_include_depth = 1; }));
+        // the file, white space included, is larger than its tokens
+        EXPECT_EQ(limit_exceeded::limit::bytes, limit([](auto& l) { l.max_bytes = 10; }));
+        EXPECT_EQ(limit_exceeded::limit::tokens, limit([](auto& l) { l.max_tokens = 5; }));
+    }
+
+    TEST_F(px_response_test, throws_on_missing_response_file)
+    {
+        px::response_files files;
+        EXPECT_THROW(files.expand(std::vector<std::string>{ programName, "@" + (directory / "missing").string() }), std::runtime_error);
+    }
+
+    TEST_F(px_response_test, arguments_too_long_for_a_child_go_to_a_response_file)
+    {
+        px::command_line cli("cli");
+        cli.add_value_argument<std::string>("name", "-n");
+        cli.add_multi_value_argument<std::string>("words", "-w");
+        cli.parse(std::vector<std::string>{ programName, "-n", "a \"name\"", "-w", "", "'quoted'", "it's", "plain" });
+
+        std::string response_file;
+        {
+            const auto argv = cli.to_argv("child", {}, 64);
+            ASSERT_EQ(2u, argv.size());
+            response_file = argv.get_response_file();
+            EXPECT_EQ("@" + response_file, argv[1]);
+
+            px::response_files files;
+            const auto args = files.expand(std::span(argv.get(), argv.size()));
+            EXPECT_EQ(std::vector<std::string_view>({ "child", "-n", "a \"name\"", "-w", "", "'quoted'", "it's", "plain" }), args);
+
+            // a child parses the spilled form without expanding it first
+            px::command_line child("child");
+            child.set_response_files(true);
+            const auto& name = child.add_value_argument<std::string>("name", "-n");
+            const auto& words = child.add_multi_value_argument<std::string>("words", "-w");
+            child.parse(static_cast<int>(argv.size()), const_cast<char**>(argv.get()));
+            EXPECT_EQ("a \"name\"", name.get_value());
+            EXPECT_EQ(std::vector<std::string>({ "", "'quoted'", "it's", "plain" }), words.get_value());
+        }
+        EXPECT_FALSE(std::filesystem::exists(response_file));
+
+        cli.parse(std::vector<std::string>{ programName, "-n", "both ' and \"" });
+        EXPECT_THROW(cli.to_argv("child", {}, 64), std::runtime_error);
+    }
+}
@@ -0,0 +1,291 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_server.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <sys/socket.h>
+
+namespace px_tests
+{
+    class px_server_test : public ::testing::Test
+    {
+    protected:
+        px_server_test()
+        {
+            integer = builder.add_value_argument<int>("integer", "-i")
+                .set_validator([](auto i) { return i >= 0; });
+            name = builder.add_value_argument<std::string>("name", "-n");
+            if (::pipe(fds) != 0)
+            {
+                throw std::runtime_error("could not create pipe");
+            }
+        }
+
+        ~px_server_test() override
+        {
+            close_write_end();
+            ::close(fds[0]);
+        }
+
+        void close_write_end()
+        {
+            if (fds[1] >= 0)
+            {
+                ::close(fds[1]);
+                fds[1] = -1;
+            }
+        }
+
+        // sends from another thread, so that the pipe cannot fill up
+        void serve(px::command_server& server, const std::vector<std::string>& commands,
+            px::framing frame = px::framing::newline)
+        {
+            std::thread client([&]()
+                {
+                    px::command_client c(fds[1], frame);
+                    for (const auto& command : commands)
+                    {
+                        c.send(command);
+                    }
+                    close_write_end();
+                });
+            try
+            {
+                server.serve(fds[0], frame);
+            }
+            catch (...)
+            {
+                client.join();
+                throw;
+            }
+            client.join();
+        }
+
+        px::schema_builder builder{ "server" };
+        px::schema_key<int> integer{};
+        px::schema_key<std::string> name{};
+        int fds[2] = { -1, -1 };
+    };
+
+    TEST_F(px_server_test, dispatches_commands_by_first_token)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 4);
+        std::atomic<int> added = 0;
+        std::atomic<int> removed = 0;
+        server.on("add", [&](const px::parse_result& r) { added += r.get(integer); });
+        server.on("remove", [&](const px::parse_result& r) { removed += r.get(integer); });
+
+        std::vector<std::string> commands;
+        for (auto i = 0; i < 1000; ++i)
+        {
+            commands.push_back("add -i " + std::to_string(i));
+            commands.push_back("remove -i 1 -n 'some name'");
+        }
+        serve(server, commands);
+
+        EXPECT_EQ(499500, added);
+        EXPECT_EQ(1000, removed);
+    }
+
+    TEST_F(px_server_test, can_read_length_prefixed_commands)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 2);
+        std::mutex names_mutex;
+        std::vector<std::string> names;
+        server.on("greet", [&](const px::parse_result& r)
+            {
+                std::lock_guard lock(names_mutex);
+                names.push_back(r.get(name));
+            });
+
+        // longer than a read buffer, so that it is split over reads
+        const auto long_name = std::string(100000, 'a');
+        serve(server, { "greet -n 'two\nlines'", "greet -n " + long_name }, px::framing::length_prefixed);
+
+        std::sort(names.begin(), names.end());
+        EXPECT_EQ(std::vector<std::string>({ long_name, "two\nlines" }), names);
+    }
+
+    TEST_F(px_server_test, reads_a_long_command_arriving_in_small_reads)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 2);
+        std::mutex names_mutex;
+        std::vector<std::string> names;
+        server.on("greet", [&](const px::parse_result& r)
+            {
+                std::lock_guard lock(names_mutex);
+                names.push_back(r.get(name));
+            });
+
+        const auto long_name = std::string(100000, 'a');
+        const auto text = "greet -n " + long_name + "\ngreet -n " + long_name + "b\n";
+        std::thread client([&]()
+            {
+                // the server sees the command a little at a time
+                for (std::size_t i = 0; i < text.size(); i += 100)
+                {
+                    const auto chunk = std::string_view(text).substr(i, 100);
+                    ASSERT_EQ(static_cast<ssize_t>(chunk.size()), ::write(fds[1], chunk.data(), chunk.size()));
+                    if (i % 10000 == 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    }
+                }
+                close_write_end();
+            });
+        server.serve(fds[0]);
+        client.join();
+
+        std::sort(names.begin(), names.end());
+        EXPECT_EQ(std::vector<std::string>({ long_name, long_name + "b" }), names);
+    }
+
+    TEST_F(px_server_test, reports_errors_per_command)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 2);
+        std::atomic<int> handled = 0;
+        server.on("add", [&](const px::parse_result&) { ++handled; });
+        server.on("throw", [&](const px::parse_result&) { throw std::runtime_error("handler failed"); });
+        std::mutex failed_mutex;
+        std::vector<std::string> failed;
+        server.on_error([&](std::string_view command, std::exception_ptr)
+            {
+                std::lock_guard lock(failed_mutex);
+                failed.emplace_back(command);
+            });
+
+        serve(server, { "add -i 1", "unknown", "add -i -1", "throw", "", "add -i 2" });
+
+        std::sort(failed.begin(), failed.end());
+        EXPECT_EQ(std::vector<std::string>({ "add -i -1", "throw", "unknown" }), failed);
+        EXPECT_EQ(2, handled);
+    }
+
+    TEST_F(px_server_test, calls_error_handler_one_at_a_time)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 4);
+        std::atomic<bool> inside = false;
+        auto overlapped = false;
+        auto failed = 0;
+        server.on_error([&](std::string_view, std::exception_ptr)
+            {
+                overlapped = overlapped || inside.exchange(true);
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+                ++failed;
+                inside = false;
+            });
+
+        serve(server, std::vector<std::string>(200, "unknown"));
+
+        EXPECT_FALSE(overlapped);
+        EXPECT_EQ(200, failed);
+    }
+
+    TEST_F(px_server_test, handles_commands_read_before_a_read_error)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 2);
+        std::atomic<int> handled = 0;
+        server.on("add", [&](const px::parse_result&)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                ++handled;
+            });
+
+        // a socket that times out reading, which fails with EAGAIN
+        int sockets[2];
+        ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+        const timeval timeout{ 0, 50000 };
+        ASSERT_EQ(0, ::setsockopt(sockets[0], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+        px::command_client client(sockets[1]);
+        for (auto i = 0; i < 100; ++i)
+        {
+            client.send("add -i 1");
+        }
+
+        auto handled_at_error = -1;
+        try
+        {
+            server.serve(sockets[0]);
+        }
+        catch (const std::system_error&)
+        {
+            handled_at_error = handled;
+        }
+        ::close(sockets[0]);
+        ::close(sockets[1]);
+
+        EXPECT_EQ(100, handled_at_error);
+    }
+
+    TEST_F(px_server_test, rethrows_without_error_handler)
+    {
+        const auto schema = std::move(builder).freeze();
+        px::command_server server(schema, 2);
+        server.on("add", [&](const px::parse_result&) {});
+
+        EXPECT_THROW(serve(server, { "add -i 1", "unknown" }), std::runtime_error);
+    }
+
+    TEST_F(px_server_test, rejects_commands_exceeding_limits)
+    {
+        px::parse_limits limits;
+        limits.max_bytes = 1000;
+        limits.max_tokens = 4;
+        builder.set_limits(limits);
+        const auto schema = std::move(builder).freeze();
+
+        for (const auto frame : { px::framing::newline, px::framing::length_prefixed })
+        {
+            ::close(fds[0]);
+            close_write_end();
+            ASSERT_EQ(0, ::pipe(fds));
+
+            px::command_server server(schema, 2);
+            std::atomic<int> handled = 0;
+            server.on("add", [&](const px::parse_result&) { ++handled; });
+            std::atomic<int> exceeded = 0;
+            server.on_error([&](std::string_view, std::exception_ptr e)
+                {
+                    try
+                    {
+                        std::rethrow_exception(e);
+                    }
+                    catch (const px::limit_exceeded&)
+                    {
+                        ++exceeded;
+                    }
+                    catch (...)
+                    {
+                    }
+                });
+
+            serve(server, { "add -i 1", "add -n " + std::string(200000, 'a'), "add -i 1 -i 2 -i 3", "add -i 2" }, frame);
+
+            EXPECT_EQ(2, handled);
+            EXPECT_EQ(2, exceeded);
+        }
+    }
+}
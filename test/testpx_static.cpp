@@ -0,0 +1,83 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// only the declarations are included here; everything used must come from
+// the explicit instantiations in px_static
+#include "px_decl.h"
+
+#include <gtest/gtest.h>
+#include <filesystem>
+
+namespace
+{
+    const std::string programName("piet");
+}
+
+namespace px_tests
+{
+    class px_static_test : public ::testing::Test
+    {
+    protected:
+        px::command_line cli{ "cli" };
+    };
+
+    TEST_F(px_static_test, can_parse_common_types_from_declarations_only)
+    {
+        auto flag = false;
+        auto i = 0;
+        auto d = 0.;
+        std::filesystem::path p;
+        std::vector<std::string> s;
+        cli.add_flag_argument("flag", "-f").bind(&flag);
+        cli.add_value_argument<int>("integer", "-i").bind(&i);
+        cli.add_value_argument<double>("double", "-d").bind(&d);
+        cli.add_value_argument<std::filesystem::path>("path", "-p").bind(&p);
+        cli.add_multi_value_argument<std::string>("strings", "-s").bind(&s);
+
+        const std::vector<std::string> args{ programName, "-f", "-i", "3", "-d", "0.5", "-p", "a/b", "-s", "x", "y" };
+        cli.parse(args);
+
+        EXPECT_TRUE(flag);
+        EXPECT_EQ(3, i);
+        EXPECT_DOUBLE_EQ(0.5, d);
+        EXPECT_EQ(std::filesystem::path("a/b"), p);
+        EXPECT_EQ((std::vector<std::string>{ "x", "y" }), s);
+    }
+
+    TEST_F(px_static_test, can_parse_positional_arg_from_declarations_only)
+    {
+        auto& arg = cli.add_positional_argument<long>("long");
+
+        const std::vector<std::string> args{ programName, "12" };
+        cli.parse(args);
+
+        EXPECT_EQ(12, arg.get_value());
+    }
+
+    TEST_F(px_static_test, can_get_value_by_name_from_declarations_only)
+    {
+        cli.add_value_argument<double>("double", "-d");
+        cli.add_multi_value_argument<int>("ints", "-i");
+
+        const std::vector<std::string> args{ programName, "-d", "0.5", "-i", "1", "2" };
+        cli.parse(args);
+
+        EXPECT_EQ(0.5, cli.get<double>("double"));
+        EXPECT_EQ(std::vector<int>({ 1, 2 }), cli.get<std::vector<int>>(px::name_key("ints")));
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    const std::string programName("piet");
+
+    std::size_t count(const std::string& text, std::string_view what)
+    {
+        std::size_t n = 0;
+        for (auto i = text.find(what); i != std::string::npos; i = text.find(what, i + 1))
+        {
+            ++n;
+        }
+        return n;
+    }
+}
+
+namespace px_tests
+{
+    class px_trace_test : public ::testing::Test
+    {
+    protected:
+        px_trace_test()
+        {
+            cli.add_value_argument<int>("count", "-n")
+                .bind(&n);
+            cli.add_multi_value_argument<std::string>("say \"hi\"", "-s")
+                .set_validator([](const auto& v) { return !v.empty(); });
+            cli.add_value_argument<double>("ratio", "-r")
+                .set_default([] { return 0.5; });
+        }
+
+        std::string trace(const px::parse_tracer& tracer)
+        {
+            std::string text;
+            px::string_sink sink(text);
+            tracer.write(sink);
+            return text;
+        }
+
+        px::command_line cli{ "the program" };
+        int n = 0;
+        const std::vector<std::string> args{ programName, "-n", "3", "-s", "a", "b" };
+    };
+
+    TEST_F(px_trace_test, records_phases_and_arguments)
+    {
+        px::parse_tracer tracer;
+        cli.set_tracer(&tracer);
+        cli.parse(args);
+
+        const auto text = trace(tracer);
+        EXPECT_EQ(0u, text.find("{\"traceEvents\":["));
+        EXPECT_EQ(tracer.size(), count(text, "\"ph\":\"X\""));
+        for (const auto* span : { "\"name\":\"parse\",\"cat\":\"px\"", "\"name\":\"limits\"", "\"name\":\"dispatch\"",
+            "\"name\":\"validation\"", "\"name\":\"count\",\"cat\":\"convert\"", "\"name\":\"count\",\"cat\":\"bind\"",
+            "\"name\":\"say \\\"hi\\\"\",\"cat\":\"validate\"", "\"name\":\"ratio\",\"cat\":\"default\"" })
+        {
+            EXPECT_EQ(1u, count(text, span)) << span << " in " << text;
+        }
+        EXPECT_EQ(0u, tracer.get_dropped());
+    }
+
+    TEST_F(px_trace_test, keeps_the_latest_spans_when_full)
+    {
+        px::parse_tracer tracer(4);
+        cli.set_tracer(&tracer);
+        cli.parse(args);
+
+        EXPECT_EQ(4u, tracer.size());
+        EXPECT_LT(0u, tracer.get_dropped());
+        // the whole parse ends last
+        const auto text = trace(tracer);
+        EXPECT_EQ(4u, count(text, "\"ph\":\"X\""));
+        EXPECT_EQ(1u, count(text, "\"name\":\"parse\",\"cat\":\"px\""));
+
+        tracer.clear();
+        EXPECT_EQ(0u, tracer.size());
+    }
+
+    TEST_F(px_trace_test, records_nothing_without_a_tracer)
+    {
+        px::parse_tracer tracer;
+        cli.set_tracer(&tracer);
+        cli.set_tracer(nullptr);
+        cli.parse(args);
+        EXPECT_EQ(0u, tracer.size());
+        EXPECT_EQ(3, n);
+    }
+}
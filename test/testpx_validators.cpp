@@ -0,0 +1,280 @@
+/*
+ * this file is part of px - a command line argument parser in modern C++
+ * Copyright (C) 2020 Sjoerd Crijns
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "px_validators.h"
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+    const std::string programName("piet");
+}
+
+namespace px_tests
+{
+    class px_memoized_test : public ::testing::Test
+    {
+    protected:
+        px::command_line cli{ "the program" };
+        std::vector<std::string> checked;
+    };
+
+    TEST_F(px_memoized_test, checks_each_distinct_value_once)
+    {
+        px::memoized<std::string> validator([this](const std::string& s) { checked.push_back(s); return s != "bad"; });
+        auto& arg = cli.add_multi_value_argument<std::string>("directories", "-d")
+            .set_validator(validator);
+
+        const std::vector<std::string> args{ programName, "-d", "a", "b", "a", "a", "b", "c" };
+        cli.parse(args);
+
+        EXPECT_EQ((std::vector<std::string>{ "a", "b", "c" }), checked);
+        const auto statistics = validator.get_statistics();
+        EXPECT_EQ(6u, statistics.checks);
+        EXPECT_EQ(3u, statistics.hits);
+        EXPECT_DOUBLE_EQ(0.5, statistics.hit_rate());
+
+        // validating again checks nothing
+        EXPECT_TRUE(arg.is_valid());
+        EXPECT_EQ(3u, checked.size());
+    }
+
+    TEST_F(px_memoized_test, remembers_invalid_values)
+    {
+        px::memoized<std::string> validator([this](const std::string& s) { checked.push_back(s); return s != "bad"; });
+
+        EXPECT_FALSE(validator(std::vector<std::string>{ "bad", "a" }));
+        EXPECT_FALSE(validator("bad"));
+        EXPECT_TRUE(validator(std::vector<std::string>{ "a", "a" }));
+        EXPECT_EQ((std::vector<std::string>{ "bad", "a" }), checked);
+    }
+
+    TEST_F(px_memoized_test, memoizes_paths_and_empties_a_full_memo)
+    {
+        auto checks = 0;
+        px::memoized<std::filesystem::path> validator([&checks](const std::filesystem::path&) { ++checks; return true; }, 2);
+
+        EXPECT_TRUE(validator(std::vector<std::filesystem::path>{ "a", "b", "a", "b" }));
+        EXPECT_EQ(2, checks);
+        EXPECT_TRUE(validator(std::vector<std::filesystem::path>{ "c", "a" }));
+        EXPECT_EQ(4, checks);
+    }
+
+    class px_validation_cache_test : public ::testing::Test
+    {
+    protected:
+        ~px_validation_cache_test() override
+        {
+            std::filesystem::remove_all(directory);
+        }
+
+        std::filesystem::path write_file(const std::string& name, const std::string& text)
+        {
+            const auto path = directory / name;
+            std::ofstream(path) << text;
+            return path;
+        }
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() /
+            ("px_validation_cache_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        bool created = std::filesystem::create_directories(directory);
+        std::filesystem::path cache_file = directory / "cache" / "validations";
+        int checks = 0;
+        px::validation_cache::check_function is_small = [this](const std::filesystem::path& p)
+        {
+            ++checks;
+            return std::filesystem::file_size(p) < 10;
+        };
+    };
+
+    TEST_F(px_validation_cache_test, later_runs_use_recorded_outcomes)
+    {
+        const auto small = write_file("small", "1");
+        const auto large = write_file("large", "0123456789");
+        {
+            px::validation_cache cache(cache_file);
+            ASSERT_TRUE(cache.is_mapped());
+            const auto validator = cache.wrap("small", is_small);
+            EXPECT_TRUE(validator(small));
+            EXPECT_FALSE(validator(large));
+        }
+
+        px::validation_cache cache(cache_file);
+        const auto validator = cache.wrap("small", is_small);
+        EXPECT_TRUE(validator(small));
+        EXPECT_FALSE(validator(large));
+        EXPECT_EQ(2, checks);
+        EXPECT_EQ(2u, cache.get_statistics().hits);
+
+        // another check of the same file is not answered by this one
+        EXPECT_TRUE(cache.wrap("large", [this](const auto& p) { return !is_small(p); })(large));
+        EXPECT_EQ(3, checks);
+    }
+
+    TEST_F(px_validation_cache_test, caches_created_at_once_with_different_sizes_share_the_file)
+    {
+        std::vector<std::filesystem::path> files;
+        for (auto i = 0; i < 64; ++i)
+        {
+            files.push_back(write_file("file" + std::to_string(i), std::string(i % 20, 'x')));
+        }
+
+        std::vector<std::thread> threads;
+        std::atomic<int> wrong = 0;
+        for (std::size_t t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    px::validation_cache cache(cache_file, std::size_t{ 64 } << t);
+                    const auto validator = cache.wrap("small",
+                        [](const std::filesystem::path& p) { return std::filesystem::file_size(p) < 10; });
+                    for (std::size_t i = 0; i < files.size(); ++i)
+                    {
+                        wrong += (validator(files[i]) != (i % 20 < 10)) ? 1 : 0;
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        EXPECT_EQ(0, wrong);
+    }
+
+    TEST_F(px_validation_cache_test, changed_files_are_checked_again)
+    {
+        const auto file = write_file("file", "1");
+        px::validation_cache cache(cache_file);
+        const auto validator = cache.wrap("small", is_small);
+        EXPECT_TRUE(validator(file));
+
+        write_file("file", "0123456789");
+        std::filesystem::last_write_time(file, std::filesystem::last_write_time(file) + std::chrono::seconds(1));
+        EXPECT_FALSE(validator(file));
+        EXPECT_EQ(2, checks);
+    }
+
+    TEST_F(px_validation_cache_test, concurrent_users_see_consistent_outcomes)
+    {
+        std::vector<std::filesystem::path> files;
+        for (auto i = 0; i < 64; ++i)
+        {
+            files.push_back(write_file(std::to_string(i), std::string(static_cast<std::size_t>(i % 20), 'x')));
+        }
+
+        // each with its own mapping, as separate processes would have
+        std::atomic<int> wrong{ 0 };
+        std::vector<std::thread> threads;
+        for (auto t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&]
+            {
+                px::validation_cache cache(cache_file, 16);
+                const auto validator = cache.wrap("small", [](const auto& p) { return std::filesystem::file_size(p) < 10; });
+                for (auto round = 0; round < 50; ++round)
+                {
+                    for (std::size_t i = 0; i < files.size(); ++i)
+                    {
+                        if (validator(files[i]) != (i % 20 < 10))
+                        {
+                            ++wrong;
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        EXPECT_EQ(0, wrong);
+    }
+
+    TEST(px_pattern_test, matches_whole_values)
+    {
+        const px::pattern identifier("[A-Za-z_]\\w*");
+        EXPECT_TRUE(identifier.matches("snake_case1"));
+        EXPECT_FALSE(identifier.matches("1abc"));
+        EXPECT_FALSE(identifier.matches("abc-def"));
+        EXPECT_FALSE(identifier.matches(""));
+
+        const px::pattern version("v?\\d+(\\.\\d+)*(-(rc|beta)\\d*)?");
+        EXPECT_TRUE(version.matches("1.2.3"));
+        EXPECT_TRUE(version.matches("v10-rc2"));
+        EXPECT_TRUE(version.matches("2-beta"));
+        EXPECT_FALSE(version.matches("1..2"));
+        EXPECT_FALSE(version.matches("1.2-alpha"));
+
+        const px::pattern escaped("a\\*[^]\\d.]+\\.?");
+        EXPECT_TRUE(escaped.matches("a*bc."));
+        EXPECT_FALSE(escaped.matches("a*b1"));
+        EXPECT_FALSE(escaped.matches("ab"));
+    }
+
+    TEST(px_pattern_test, rejects_malformed_patterns)
+    {
+        for (const auto* bad : { "(a", "a)", "*a", "a|+", "[a-", "[z-a]", "a\\" })
+        {
+            EXPECT_THROW(px::pattern{ bad }, std::logic_error) << bad;
+        }
+    }
+
+    TEST(px_pattern_test, translates_shell_patterns)
+    {
+        const auto parquet = px::pattern::glob("part-[0-9]*.parquet");
+        EXPECT_TRUE(parquet.matches("part-0001.parquet"));
+        EXPECT_FALSE(parquet.matches("part-x.parquet"));
+        EXPECT_FALSE(parquet.matches("part-1.parquetx"));
+        EXPECT_TRUE(px::pattern::glob("[!.]?(x)").matches("ab(x)"));
+        EXPECT_FALSE(px::pattern::glob("[!.]?(x)").matches(".b(x)"));
+        EXPECT_EQ("part-[0-9]*.parquet", parquet.get_expression());
+    }
+
+    TEST(px_pattern_test, validates_elements_and_shows_in_help)
+    {
+        px::command_line cli("the program");
+        auto& inputs = cli.add_multi_value_argument<std::filesystem::path>("inputs", "-i")
+            .set_description("input files")
+            .set_validator(px::pattern::glob("*.parquet"));
+        auto& name = cli.add_value_argument<std::string>("name", "-n")
+            .set_validator(px::pattern("[a-z]+"));
+
+        std::string help;
+        px::string_sink sink(help);
+        cli.print_help(sink);
+        EXPECT_NE(std::string::npos, help.find("input files (matching '*.parquet')")) << help;
+        EXPECT_NE(std::string::npos, help.find("(matching '[a-z]+')")) << help;
+
+        const std::vector<std::string> args{ programName, "-n", "abc", "-i", "a.parquet", "b.parquet" };
+        cli.parse(args);
+        EXPECT_TRUE(inputs.is_valid());
+        EXPECT_TRUE(name.is_valid());
+
+        const std::vector<std::string> invalid{ programName, "-i", "a.parquet", "b.csv" };
+        EXPECT_THROW(cli.parse(invalid), std::runtime_error);
+
+        // a plain validator says nothing
+        name.set_validator([](const std::string&) { return true; });
+        help.clear();
+        cli.print_help(sink);
+        EXPECT_EQ(std::string::npos, help.find("(matching '[a-z]+')")) << help;
+    }
+}